@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "image_pool.h"
+#include "interpolation.h"
+#include "json.h"
+#include "parallel.h"
+#include "read.h"
+#include "simd.h"
+#include "write.h"
+
+using namespace std;
+
+/**
+ * 插值熱點的微基準測試
+ *
+ * 以固定的合成影像 (與亂數種子無關，每次執行都相同) 測試各個函式在不同大小 (M x M) 與 K 下的效能，
+ * 每個項目先執行一次暖機，再重複執行數次，輸出平均時間、每像素時間、頻寬與各次之間的變異數。
+ * 結果同時寫成 JSON，方便比較不同版本的結果。
+ *
+ * 用法：./bench [--reps <n>] [--sizes 64,256,...] [--ks 1,2,...] [--filter <name>] [--out <file.json>] [--tmp <dir>]
+ */
+
+#define SCALE 8                   // 輸入影像的大小為輸出的 1/8 (與 image1 -> image2 相同)
+#define LAGRANGE_CALLS (1 << 16)  // lagrange 每次執行的呼叫次數
+
+struct Result {
+    string name;
+    int size, k;           // size 為輸出影像的邊長，與大小無關的項目為 0；與 K 無關的項目 K 為 0
+    double pixels, bytes;  // 每次執行處理的像素數 (或呼叫次數) 與讀寫的資料量
+    vector<double> ns;     // 每次執行的時間 (ns)
+
+    double mean() const {
+        double s = 0;
+        for (double t : ns)
+            s += t;
+        return s / ns.size();
+    }
+    double variance() const {  // 樣本變異數 (ns²)
+        if (ns.size() < 2) return 0;
+        double m = mean(), s = 0;
+        for (double t : ns)
+            s += (t - m) * (t - m);
+        return s / (ns.size() - 1);
+    }
+    double min() const { return *min_element(ns.begin(), ns.end()); }
+};
+
+// 固定的合成影像：平滑的圖案加上雜訊，數值在 [0, 1] 之間
+static Image synthetic_image(int width, int height) {
+    Image image = zerosImage(width, height, NULL);
+    unsigned state = 12345;
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            state = state * 1103515245u + 12345u;  // 線性同餘產生器，結果與平台無關
+            double noise = (state >> 8) / 16777216.0;
+            image.data[i][j] = (float)(0.45 + 0.35 * sin(i * 0.05) * cos(j * 0.07) + 0.2 * noise);
+        }
+    }
+    return image;
+}
+
+struct Options {
+    int reps = 5;
+    vector<int> sizes = {64, 256, 1024, 4096};
+    vector<int> ks = {1, 2, 4, 8, 16, 32, 64};
+    string filter, out = "bench.json", tmp = ".";
+};
+
+static vector<int> parse_list(const char* s) {
+    vector<int> v;
+    for (const char* p = s; *p;) {
+        v.push_back(atoi(p));
+        const char* comma = strchr(p, ',');
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return v;
+}
+
+static vector<Result> results;
+
+// 項目是否符合 --filter 的條件
+static bool selected(const Options& opt, const string& name) {
+    return opt.filter.empty() || name.find(opt.filter) != string::npos;
+}
+
+/**
+ * 測量一個項目：暖機一次後重複執行 reps 次，印出並記錄結果
+ *
+ * @param opt 選項 (重複次數、過濾條件)
+ * @param name 項目名稱
+ * @param size 輸出影像的邊長
+ * @param k 區塊大小
+ * @param pixels 每次執行處理的像素數
+ * @param bytes 每次執行讀寫的資料量
+ * @param run 要測量的函式
+ */
+static void measure(const Options& opt, const string& name, int size, int k, double pixels, double bytes,
+                    const function<void()>& run) {
+    if (!selected(opt, name)) return;
+
+    Result r = {name, size, k, pixels, bytes, {}};
+    run();  // 暖機
+    for (int i = 0; i < opt.reps; i++) {
+        auto t0 = chrono::steady_clock::now();
+        run();
+        auto t1 = chrono::steady_clock::now();
+        r.ns.push_back(chrono::duration<double, nano>(t1 - t0).count());
+    }
+
+    double mean = r.mean();
+    printf("%-22s %5d %3d %12.3f %10.3f %9.2f%%\n", name.c_str(), size, k, mean / pixels, bytes / mean,
+           100 * sqrt(r.variance()) / mean);
+    fflush(stdout);
+    results.push_back(r);
+}
+
+static bool write_json(const Options& opt) {
+    FILE* file = fopen(opt.out.c_str(), "w");
+    if (!file) {
+        perror("Error opening output file");
+        return false;
+    }
+
+    string out = "{\n    \"threads\": " + to_string(default_threads()) + ",\n    \"simd_bytes\": " +
+                 to_string(SIMD_BYTES) + ",\n    \"repetitions\": " + to_string(opt.reps) + ",\n    \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        double mean = r.mean();
+        out += string(i ? "," : "") + "\n        {\"name\": " + json_string(r.name) + ", \"size\": " +
+               to_string(r.size) + ", \"k\": " + to_string(r.k) + ", \"pixels\": " + to_string((long long)r.pixels) +
+               ", \"bytes\": " + to_string((long long)r.bytes) + ", \"mean_ns\": " + json_number(mean, 1) +
+               ", \"min_ns\": " + json_number(r.min(), 1) + ", \"variance_ns2\": " + json_number(r.variance(), 1) +
+               ", \"ns_per_pixel\": " + json_number(mean / r.pixels, 4) +
+               ", \"gb_per_s\": " + json_number(r.bytes / mean, 4) + "}";
+    }
+    out += "\n    ]\n}\n";
+
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) perror("Error writing output file");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--reps") == 0)
+            opt.reps = max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--sizes") == 0)
+            opt.sizes = parse_list(argv[i + 1]);
+        else if (strcmp(argv[i], "--ks") == 0)
+            opt.ks = parse_list(argv[i + 1]);
+        else if (strcmp(argv[i], "--filter") == 0)
+            opt.filter = argv[i + 1];
+        else if (strcmp(argv[i], "--out") == 0)
+            opt.out = argv[i + 1];
+        else if (strcmp(argv[i], "--tmp") == 0)
+            opt.tmp = argv[i + 1];
+        else
+            cerr << "Warning: Unknown option " << argv[i] << endl;
+    }
+
+    printf("%-22s %5s %3s %12s %10s %10s\n", "benchmark", "size", "K", "ns/pixel", "GB/s", "stddev");
+    volatile double sink = 0;  // 避免結果被編譯器最佳化掉
+
+    // 與影像大小無關：一次 Lagrange 插值 (K 個取樣點)
+    for (int k : opt.ks) {
+        vector<double> ys(k);
+        for (int i = 0; i < k; i++)
+            ys[i] = 0.5 + 0.4 * sin(i * 0.3);
+        measure(opt, "lagrange", 0, k, LAGRANGE_CALLS, (double)(LAGRANGE_CALLS) * k * sizeof(double), [&] {
+            double s = 0;
+            for (int c = 0; c < LAGRANGE_CALLS; c++)
+                s += lagrange(ys, (c % 1024) * (k - 1) / 1024.0);
+            sink = sink + s;
+        });
+    }
+
+    for (int size : opt.sizes) {
+        int N = max(1, size / SCALE), M = size;
+        Image src = synthetic_image(N, N);
+        Image mid = zerosImage(M, N, NULL);  // 列方向插值的結果
+
+        for (int k : opt.ks) {
+            if (k > N) continue;  // 區塊不能比輸入大
+
+            // 輸出影像的每個像素都會查詢一次取樣範圍
+            measure(opt, "get_block_range", size, k, (double)M * M, 0, [&] {
+                long long s = 0;
+                for (int i = 0; i < M; i++)
+                    for (int j = 0; j < M; j++)
+                        s += get_block_range((int)((long long)j * N / M), N, k).first;
+                sink = sink + s;
+            });
+
+            double row_bytes = ((double)N * N + (double)M * N) * sizeof(float);
+            measure(opt, "super_row/block", size, k, (double)M * N, row_bytes,
+                    [&] { super_row(src, mid, k, false); });
+            measure(opt, "super_row/overlap", size, k, (double)M * N, row_bytes,
+                    [&] { super_row(src, mid, k, true); });
+            measure(opt, "sliding_row", size, k, (double)M * N, row_bytes, [&] { sliding_row(src, mid, k); });
+
+            // 完整的 super sampling (單執行緒)
+            Image dst = zerosImage(M, M, NULL);
+            measure(opt, "super_sample/sliding", size, k, (double)M * M,
+                    ((double)N * N + (double)M * M) * sizeof(float),
+                    [&] { super_sample(src, dst, k, USE_METHOD_SLIDING | CLAMP_AT_END, 1); });
+            freeImage(dst);
+        }
+        freeImage(mid);
+        freeImage(src);
+
+        // 與 K 無關：轉置與檔案讀寫
+        Image image = synthetic_image(M, M);
+        double bytes = (double)M * M * sizeof(float);
+        Image transposed = acquireImage(M, M, false);  // 轉置到重複使用的緩衝區，不計入配置記憶體的時間
+        measure(opt, "transposeImageTo", size, 0, (double)M * M, 2 * bytes,
+                [&] { transposeImageTo(&image, &transposed); });
+        releaseImage(transposed);
+
+        for (const char* ext : {".txt", ".bin"}) {
+            string filename = opt.tmp + "/bench_tmp" + ext;
+            string kind = ext + 1;
+            if (!selected(opt, "writeImage/" + kind) && !selected(opt, "readImage/" + kind)) continue;
+            writeImage(filename.c_str(), image);
+            FILE* f = fopen(filename.c_str(), "rb");
+            double fileBytes = 0;
+            if (f) fseek(f, 0, SEEK_END), fileBytes = ftell(f), fclose(f);
+
+            measure(opt, "writeImage/" + kind, size, 0, (double)M * M, fileBytes,
+                    [&] { writeImage(filename.c_str(), image); });
+            measure(opt, "readImage/" + kind, size, 0, (double)M * M, fileBytes, [&] {
+                Image img = readImage(filename.c_str());
+                if (!img.data) exit(EXIT_FAILURE);
+                if (img.mapping) {  // 二進位格式以 mmap 開啟，讀取所有像素才會真正讀到資料
+                    double s = 0;
+                    for (int i = 0; i < img.height; i++)
+                        for (int j = 0; j < img.width; j++)
+                            s += img.data[i][j];
+                    sink = sink + s;
+                }
+                freeImage(img);
+            });
+            remove(filename.c_str());
+        }
+        freeImage(image);
+    }
+
+    return write_json(opt) ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "json.h"
+#include "metrics.h"
+#include "read.h"
+
+using namespace std;
+
+/**
+ * 比較影像與參考影像的差異，以 JSON 輸出 MSE、PSNR、SSIM
+ * 數值的位數與 `plots/` 的 JSON 檔案相同 (MSE、SSIM 四捨五入到小數點後 6 位，PSNR 為 2 位)
+ *
+ * 用法：./compare [--threads <n>] <reference> <img1> <img2> ...
+ */
+int main(int argc, char** argv) {
+    int threads = 0;  // 執行緒數量 (0: 使用所有核心)
+    int arg = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "--threads") == 0) threads = atoi(argv[arg + 1]), arg += 2;
+    if (argc - arg < 2) {
+        cerr << "usage: " << argv[0] << " [--threads <n>] <reference> <img1> <img2> < ... >" << endl;
+        return 1;
+    }
+
+    Image ref = readImage(argv[arg]);
+    if (!ref.data) {
+        cerr << "Error: Unable to read image from " << argv[arg] << endl;
+        return 1;
+    }
+
+    // 依序比較每張影像，無法比較的影像不會出現在結果中
+    int failed = 0;
+    vector<string> entries;
+    for (int i = arg + 1; i < argc; i++) {
+        Image img = readImage(argv[i]);
+        ImageMetrics m;
+        if (!img.data) {
+            cerr << "Error: Unable to read image from " << argv[i] << endl;
+            failed++;
+            continue;
+        }
+        if (!compare_images(ref, img, m, threads)) {
+            cerr << "Error: Image size mismatch: " << argv[i] << endl;
+            failed++;
+        } else {
+            entries.push_back(json_string(argv[i]) + ": {\"MSE\": " + json_number(m.mse) + ", \"PSNR\": " +
+                              json_number(m.psnr, 2) + ", \"SSIM\": " + json_number(m.ssim) + "}");
+        }
+        freeImage(img);
+    }
+    freeImage(ref);
+
+    cout << "{\n    \"reference\": " << json_string(argv[arg]) << ",\n    \"results\": {";
+    for (size_t i = 0; i < entries.size(); i++)
+        cout << (i ? ",\n" : "\n") << "        " << entries[i];
+    cout << (entries.empty() ? "}\n}" : "\n    }\n}") << endl;
+
+    return failed ? 1 : 0;
+}
@@ -2,37 +2,28 @@ import json
 from collections import namedtuple
 from glob import glob
 from subprocess import PIPE, Popen
-from sys import argv, platform
+from sys import argv
 
 import matplotlib.pyplot as plt
 from matplotlib.ticker import AutoMinorLocator, MaxNLocator, MultipleLocator
 from mpl_toolkits.axes_grid1 import host_subplot
-from tqdm import tqdm
 
 ComparisonResult = namedtuple("ComparisonResult", ["MSE", "PSNR", "SSIM"])
 
 
-def compare_images(img1_path, img2_path):
-    """比較兩張影像的差異"""
-    # Construct the command to run the comparison tool
-    command = ["./compare.exe", img1_path, img2_path]
+def compare_images(reference, images):
+    """比較多張影像與參考影像的差異 (使用 make compare 編譯的 ./compare)"""
+    command = ["./compare", reference, *images]
 
     # Execute the command
     process = Popen(command, stdout=PIPE, stderr=PIPE)
     stdout, stderr = process.communicate()
 
-    outs = stdout.decode().strip().splitlines()
+    if process.returncode != 0:  # 錯誤訊息
+        raise RuntimeError(stderr.decode().strip())
 
-    if len(outs) == 3:  # 錯誤訊息
-        raise RuntimeError(outs[2])
-
-    results = ComparisonResult(
-        MSE=float(outs[16][9:]),
-        PSNR=float(outs[17][9:-3]),
-        SSIM=float(outs[18][9:]),
-    )
-
-    return results
+    results = json.loads(stdout)["results"]
+    return {img: ComparisonResult(**results[img]) for img in images}
 
 
 def show_psnr_ssim_plot(filename: str, keys: list, psnr: list, ssim: list):
@@ -127,10 +118,6 @@ def show_diff_plot(
 
 
 if __name__ == "__main__":
-    if not platform.startswith("win"):
-        print("This script is only supported on Windows.")
-        exit(1)
-
     if len(argv) == 2:
         images = glob(argv[1])
     elif len(argv) > 2:
@@ -142,18 +129,19 @@ if __name__ == "__main__":
     if images:  # 有指定影像檔案
         width = max(len(img) for img in images) + 1
 
+        results = compare_images("image/image2.txt", images)
         for img in images:
-            result = compare_images("image/image2.txt", img)
-            print(f"{img+':':<{width}} {result}")
+            print(f"{img+':':<{width}} {results[img]}")
     else:
         mse, psnr, ssim = {}, {}, {}
 
-        for k in tqdm(range(1, 65), desc="Comparing images"):
-            img = f"image/output_{k}.txt"
-            result = compare_images("image/image2.txt", img)
-            mse[k] = result.MSE
-            psnr[k] = result.PSNR
-            ssim[k] = result.SSIM
+        keys = list(range(1, 65))
+        images = [f"image/output_{k}.txt" for k in keys]
+        results = compare_images("image/image2.txt", images)
+        for k, img in zip(keys, images):
+            mse[k] = results[img].MSE
+            psnr[k] = results[img].PSNR
+            ssim[k] = results[img].SSIM
 
         filename = "plots/sliding_1.json"
 
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 
 #include "image.h"
+#include "image_bin.h"
 #include "read.h"
 #include "stb_image_write.h"
 
@@ -13,7 +14,7 @@ void writePNG(const char* filename, Image image) {
 
     for (int i = 0; i < h; i++) {
         for (int j = 0; j < w; j++) {
-            buffer[i * w + j] = (uint8_t)(image.buffer[(h - i - 1) * w + j] * 255);
+            buffer[i * w + j] = (uint8_t)(image.data[h - i - 1][j] * 255);
         }
     }
 
@@ -22,13 +23,14 @@ void writePNG(const char* filename, Image image) {
 }
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        fprintf(stderr, "usage: %s <img1.txt> <img2.txt> < ... >\n", argv[0]);
+    int toBinary = argc > 1 && strcmp(argv[1], "--bin") == 0;  // 轉成二進位格式而不是 PNG
+    if (argc < 2 + toBinary) {
+        fprintf(stderr, "usage: %s [--bin] <img1.txt> <img2.txt> < ... >\n", argv[0]);
         return 1;
     }
 
     // 依序處理每個圖像
-    for (int i = 1; i < argc; i++) {
+    for (int i = 1 + toBinary; i < argc; i++) {
         Image img = readImage(argv[i]);
 
         if (!img.data) {
@@ -36,13 +38,16 @@ int main(int argc, char** argv) {
             continue;
         }
 
-        // 產生輸出檔名 *.txt -> *.png
+        // 產生輸出檔名 *.txt -> *.png (或 *.bin)
         int len = strlen(argv[i]);
         char* output = (char*)malloc((len + 1) * sizeof(char));
         strcpy(output, argv[i]);
-        output[len - 3] = 'p', output[len - 2] = 'n', output[len - 1] = 'g';
+        strcpy(output + len - 3, toBinary ? "bin" : "png");
 
-        writePNG(output, img);
+        if (!toBinary)
+            writePNG(output, img);
+        else if (strcmp(output, argv[i]) == 0 || writeBinaryImage(output, img) != 0)
+            fprintf(stderr, "Error: Unable to write image to %s\n", output);
         free(output);
         freeImage(img);
     }
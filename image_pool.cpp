@@ -0,0 +1,122 @@
+#include "image_pool.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "image.h"
+#include "stats.h"
+
+#define HUGE_PAGE (2 << 20)  // huge page 的大小 (2 MB)
+
+static std::mutex pool_lock;
+static std::map<std::pair<int, int>, std::vector<Image>> pool;  // (每列的 float 數, 高度) -> 可用的影像
+static size_t pool_bytes = 0;                                    // 池中保留的緩衝區總量
+
+// 讀取環境變數的設定，只讀取一次
+static const size_t pool_limit = [] {
+    const char* env = getenv("SUPER_POOL_LIMIT");
+    return (env ? (size_t)atoll(env) : 1024) << 20;
+}();
+static const bool huge_pages = [] {
+    const char* env = getenv("SUPER_HUGE_PAGES");
+    return env && strcmp(env, "0") != 0;
+}();
+
+// 每列補齊到 POOL_ALIGN bytes 後的 float 數
+static int row_stride(int width) {
+    const int n = POOL_ALIGN / sizeof(float);
+    return (width + n - 1) / n * n;
+}
+
+// 配置對齊的緩衝區，需要時要求使用 huge pages
+static float* allocate(size_t bytes) {
+    size_t align = POOL_ALIGN;
+    if (huge_pages && bytes >= HUGE_PAGE) align = HUGE_PAGE, bytes = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+
+    void* p = NULL;
+    if (posix_memalign(&p, align, bytes ? bytes : POOL_ALIGN) != 0) return NULL;
+#ifdef MADV_HUGEPAGE
+    if (align == HUGE_PAGE) madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return (float*)p;
+}
+
+Image acquireImage(int width, int height, bool zero) {
+    int stride = row_stride(width);
+    size_t bytes = (size_t)stride * height * sizeof(float);
+    Image image = {width, height, NULL, NULL, NULL, NULL, 0};
+
+    {
+        std::lock_guard<std::mutex> lk(pool_lock);
+        auto it = pool.find({stride, height});
+        if (it != pool.end() && !it->second.empty()) {
+            image = it->second.back();
+            it->second.pop_back();
+            pool_bytes -= bytes;
+        }
+    }
+
+    if (image.data) {  // 重複使用，列指標已經設定好了
+        image.width = width;
+        stats_add(BUFFER_REUSES, 1);
+    } else {
+        image.buffer = allocate(bytes);
+        image.data = (float**)malloc(height * sizeof(float*));
+        if (!image.buffer || !image.data) {
+            free(image.buffer), free(image.data);
+            return {0, 0, NULL, NULL, NULL, NULL, 0};
+        }
+        for (int i = 0; i < height; i++)
+            image.data[i] = image.buffer + (size_t)i * stride;
+        stats_add(BUFFER_ALLOCATIONS, 1);
+    }
+
+    if (zero) memset(image.buffer, 0, bytes);
+    return image;
+}
+
+// 影像的配置方式是否與池相同 (對齊的連續緩衝區，每列 row_stride(width) 個 float)，zerosImage 的影像也可能符合
+static bool pool_layout(const Image& img) {
+    int stride = row_stride(img.width);
+    if (img.mapping || !img.data || img.buffer != img.data[0] || (uintptr_t)img.buffer % POOL_ALIGN) return false;
+    return img.height > 1 ? img.data[1] - img.data[0] == stride : img.width == stride;
+}
+
+void releaseImage(Image& img) {
+    if (!pool_layout(img)) {
+        freeImage(img);
+    } else {
+        if (img.name) free(img.name), img.name = NULL;
+        int stride = row_stride(img.width);
+        size_t bytes = (size_t)stride * img.height * sizeof(float);
+
+        std::lock_guard<std::mutex> lk(pool_lock);
+        if (pool_bytes + bytes > pool_limit) {
+            freeImage(img);
+        } else {
+            pool[{stride, img.height}].push_back(img);
+            pool_bytes += bytes;
+        }
+    }
+    img.data = NULL, img.buffer = NULL;
+    img.width = img.height = 0;
+}
+
+void trimImagePool() {
+    std::lock_guard<std::mutex> lk(pool_lock);
+    for (auto& [key, images] : pool)
+        for (Image& img : images)
+            freeImage(img);
+    pool.clear();
+    pool_bytes = 0;
+}
+
+// 程式結束時釋放池中的緩衝區 (在 pool 之後建構，因此會先被解構)
+static struct PoolCleanup {
+    ~PoolCleanup() { trimImagePool(); }
+} pool_cleanup;
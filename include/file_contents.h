@@ -0,0 +1,63 @@
+#ifndef FILE_CONTENTS_H
+#define FILE_CONTENTS_H
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#if !(_WIN32 || _WIN64)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+// 唯讀開啟的整個檔案，支援 mmap 的平台直接對應，否則讀進記憶體
+// sequential 表示會依序讀取 (讓系統提早預讀)，否則為隨機存取
+struct FileContents {
+    const char* data = nullptr;
+    size_t size = 0;
+    bool ok = false;
+
+    explicit FileContents(const char* filename, bool sequential = true) {
+#if _WIN32 || _WIN64
+        (void)sequential;
+        FILE* file = fopen(filename, "rb");
+        if (!file) return;
+        char buf[1 << 16];
+        for (size_t n; (n = fread(buf, 1, sizeof(buf), file)) > 0;)
+            copy.append(buf, n);
+        fclose(file);
+        data = copy.data(), size = copy.size(), ok = true;
+#else
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            size = st.st_size, ok = true;
+            if (size > 0) {
+                void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map == MAP_FAILED)
+                    ok = false;
+                else
+                    data = (const char*)map, madvise(map, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~FileContents() {
+#if !(_WIN32 || _WIN64)
+        if (data) munmap((void*)data, size);
+#endif
+    }
+
+    FileContents(const FileContents&) = delete;
+    FileContents& operator=(const FileContents&) = delete;
+
+#if _WIN32 || _WIN64
+    std::string copy;
+#endif
+};
+
+#endif  // FILE_CONTENTS_H
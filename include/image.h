@@ -3,6 +3,12 @@
 
 #include <stdlib.h>
 #include <string.h>
+#if !(_WIN32 || _WIN64)
+  #include <sys/mman.h>
+#endif
+#ifdef __SSE__
+  #include <xmmintrin.h>
+#endif
 
 typedef struct {
     int width;
@@ -10,10 +16,12 @@ typedef struct {
     float** data;
     float* buffer;  // 儲存在連續的記憶體區塊中
     char* name;
+    void* mapping;   // 以 mmap 對應到檔案時為對應的起始位置，否則為 NULL (見 image_bin.h)
+    size_t mapSize;  // 對應的大小
 } Image;
 
 // 建立一個全零的影像
-static Image zerosImage(int width, int height, const char* name) {
+static inline Image zerosImage(int width, int height, const char* name) {
     Image image;
     image.width = width;
     image.height = height;
@@ -23,6 +31,8 @@ static Image zerosImage(int width, int height, const char* name) {
     } else {
         image.name = NULL;
     }
+    image.mapping = NULL;
+    image.mapSize = 0;
 
     // 連續的記憶體區塊
     image.buffer = (float*)malloc(width * height * sizeof(float));
@@ -36,22 +46,69 @@ static Image zerosImage(int width, int height, const char* name) {
 }
 
 // 清除 Image 資源
-static void freeImage(Image img) {
-    if (img.data) free(img.buffer), free(img.data);
+static inline void freeImage(Image img) {
+    if (img.mapping) {  // 像素資料在檔案中，解除對應即可
+#if !(_WIN32 || _WIN64)
+        munmap(img.mapping, img.mapSize);
+#endif
+        free(img.data);
+    } else if (img.data) {
+        free(img.buffer), free(img.data);
+    }
     if (img.name) free(img.name);
     img.name = NULL;
     img.data = NULL;
     img.width = img.height = 0;
 }
 
-// 轉置影像
-static void transposeImage(Image* img) {
+#define TRANSPOSE_TILE 32  // 轉置時的區塊大小
+
+// 轉置影像的第 [row0, row1) 列，寫入 dst 的第 [row0, row1) 行
+// 以 TRANSPOSE_TILE x TRANSPOSE_TILE 的區塊為單位，區塊內再以 4x4 的 SSE 暫存器轉置
+static inline void transposeImageRows(const Image* src, Image* dst, int row0, int row1) {
+    for (int i0 = row0; i0 < row1; i0 += TRANSPOSE_TILE) {
+        int i1 = i0 + TRANSPOSE_TILE < row1 ? i0 + TRANSPOSE_TILE : row1;
+        for (int j0 = 0; j0 < src->width; j0 += TRANSPOSE_TILE) {
+            int j1 = j0 + TRANSPOSE_TILE < src->width ? j0 + TRANSPOSE_TILE : src->width;
+            int i = i0;
+#ifdef __SSE__
+            for (; i + 4 <= i1; i += 4) {
+                int j = j0;
+                for (; j + 4 <= j1; j += 4) {
+                    __m128 r0 = _mm_loadu_ps(&src->data[i][j]), r1 = _mm_loadu_ps(&src->data[i + 1][j]);
+                    __m128 r2 = _mm_loadu_ps(&src->data[i + 2][j]), r3 = _mm_loadu_ps(&src->data[i + 3][j]);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    _mm_storeu_ps(&dst->data[j][i], r0), _mm_storeu_ps(&dst->data[j + 1][i], r1);
+                    _mm_storeu_ps(&dst->data[j + 2][i], r2), _mm_storeu_ps(&dst->data[j + 3][i], r3);
+                }
+                for (; j < j1; j++)
+                    for (int k = i; k < i + 4; k++)
+                        dst->data[j][k] = src->data[k][j];
+            }
+#endif
+            for (; i < i1; i++)
+                for (int j = j0; j < j1; j++)
+                    dst->data[j][i] = src->data[i][j];
+        }
+    }
+}
+
+// 將 src 轉置後寫入呼叫端提供的 dst，dst 的大小需為 src->height x src->width
+// 成功時回傳 0，大小不符時回傳 -1
+static inline int transposeImageTo(const Image* src, Image* dst) {
+    if (!src || !dst || !src->data || !dst->data) return -1;
+    if (dst->width != src->height || dst->height != src->width) return -1;
+    transposeImageRows(src, dst, 0, src->height);
+    return 0;
+}
+
+// 轉置影像 (原地轉置的介面)
+// 每次呼叫都會配置一張新的影像並釋放原本的影像，重複轉置時請改用 transposeImageTo 寫入重複使用的緩衝區
+static inline void transposeImage(Image* img) {
     if (!img || !img->data) return;
     Image tmp = zerosImage(img->height, img->width, img->name);
 
-    for (int i = 0; i < img->height; i++)
-        for (int j = 0; j < img->width; j++)
-            tmp.data[j][i] = img->data[i][j];
+    transposeImageTo(img, &tmp);
 
     freeImage(*img);  // 釋放原本的記憶體
     *img = tmp;       // 更新 img 為轉置後的影像
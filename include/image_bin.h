@@ -0,0 +1,234 @@
+#ifndef IMAGE_BIN_H
+#define IMAGE_BIN_H
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "image.h"
+
+#if !(_WIN32 || _WIN64)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+/**
+ * 二進位影像格式 (*.bin)
+ *
+ * 檔案開頭為 64 bytes 的標頭，之後是從 offset 開始、每列 stride bytes 的 float32 像素 (本機位元組順序)。
+ * offset 是 64 的倍數，因此以 mmap 開啟時像素資料可以直接當成 Image 使用，不需要解析或複製。
+ * 讀取時以檔案開頭的 magic number 判斷格式，與副檔名無關。
+ */
+
+#define IMAGE_BIN_VERSION 1
+#define IMAGE_BIN_ALIGN 64  // 像素資料的對齊大小
+#define IMAGE_DTYPE_F32 1   // 目前只支援 float32
+
+static const char IMAGE_BIN_MAGIC[8] = {'S', 'S', 'I', 'M', 'A', 'G', 'E', '\0'};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    int32_t width, height;
+    uint64_t stride;  // 每一列的大小 (bytes)
+    uint64_t offset;  // 像素資料在檔案中的起始位置
+    uint8_t reserved[24];
+} ImageFileHeader;
+
+typedef char ImageFileHeader_must_be_64_bytes[sizeof(ImageFileHeader) == IMAGE_BIN_ALIGN ? 1 : -1];
+
+// 檔案是否為二進位影像格式
+static inline int isBinaryImage(const char* filename) {
+    char magic[sizeof(IMAGE_BIN_MAGIC)];
+    FILE* file = fopen(filename, "rb");
+    if (!file) return 0;
+    int ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+             memcmp(magic, IMAGE_BIN_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return ok;
+}
+
+// 檔名是否以 .bin 結尾，寫出影像時用來決定格式
+static inline int hasBinaryExtension(const char* filename) {
+    size_t len = strlen(filename);
+    return len >= 4 && strcmp(filename + len - 4, ".bin") == 0;
+}
+
+// 填入 width x height、每列 stride bytes 的標頭
+static inline ImageFileHeader makeImageHeader(int width, int height) {
+    ImageFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IMAGE_BIN_MAGIC, sizeof(h.magic));
+    h.version = IMAGE_BIN_VERSION;
+    h.dtype = IMAGE_DTYPE_F32;
+    h.width = width, h.height = height;
+    h.stride = (uint64_t)width * sizeof(float);  // 列之間不留空隙，讓 buffer 保持連續
+    h.offset = sizeof(ImageFileHeader);
+    return h;
+}
+
+// 檢查標頭是否合法，且像素資料在檔案大小 size 之內
+static inline int validImageHeader(const ImageFileHeader* h, uint64_t size) {
+    if (memcmp(h->magic, IMAGE_BIN_MAGIC, sizeof(h->magic)) != 0) return 0;
+    if (h->version != IMAGE_BIN_VERSION || h->dtype != IMAGE_DTYPE_F32) return 0;
+    if (h->width <= 0 || h->height <= 0 || h->offset % IMAGE_BIN_ALIGN != 0 || h->offset < sizeof(*h)) return 0;
+    if (h->stride < (uint64_t)h->width * sizeof(float) || h->stride % sizeof(float) != 0) return 0;
+    return h->offset <= size && (size - h->offset) / h->stride >= (uint64_t)h->height;
+}
+
+// 建立指向 payload 的 Image，每一列相隔 stride bytes
+static inline Image wrapImagePixels(char* payload, const ImageFileHeader* h, const char* name) {
+    Image image;
+    image.width = h->width;
+    image.height = h->height;
+    image.name = NULL;
+    if (name) {
+        image.name = (char*)malloc((strlen(name) + 1) * sizeof(char));
+        strcpy(image.name, name);
+    }
+    image.mapping = NULL;
+    image.mapSize = 0;
+    image.buffer = (float*)payload;
+    image.data = (float**)malloc(h->height * sizeof(float*));
+    for (int i = 0; i < h->height; i++)
+        image.data[i] = (float*)(payload + i * h->stride);
+    return image;
+}
+
+/**
+ * 以 mmap 開啟二進位影像，像素資料直接指向檔案內容 (copy-on-write，修改不會寫回檔案)
+ * 不支援 mmap 的平台會讀進記憶體
+ *
+ * @param filename 檔案名稱
+ * @return Image 讀取失敗時 data 為 NULL
+ */
+static inline Image mapImage(const char* filename) {
+    Image image;
+    memset(&image, 0, sizeof(image));
+
+#if _WIN32 || _WIN64
+    FILE* file = fopen(filename, "rb");
+    ImageFileHeader h;
+    if (!file) {
+        perror("Failed to open file");
+        return image;
+    }
+    if (fread(&h, sizeof(h), 1, file) != 1 || !validImageHeader(&h, UINT64_MAX)) {
+        fprintf(stderr, "Invalid file format: %s\n", filename);
+        fclose(file);
+        return image;
+    }
+    image = zerosImage(h.width, h.height, filename);
+    for (int i = 0; i < h.height; i++) {
+        if (fseek(file, (long)(h.offset + i * h.stride), SEEK_SET) != 0 ||
+            fread(image.data[i], sizeof(float), h.width, file) != (size_t)h.width) {
+            fprintf(stderr, "Invalid pixel data at row %d\n", i);
+            freeImage(image);
+            memset(&image, 0, sizeof(image));
+            break;
+        }
+    }
+    fclose(file);
+    return image;
+#else
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0) {
+        perror("Failed to open file");
+        return image;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ImageFileHeader)) {
+        fprintf(stderr, "Invalid file format: %s\n", filename);
+        close(fd);
+        return image;
+    }
+
+    size_t size = st.st_size;
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map file");
+        return image;
+    }
+
+    const ImageFileHeader* h = (const ImageFileHeader*)map;
+    if (!validImageHeader(h, size)) {
+        fprintf(stderr, "Invalid file format: %s\n", filename);
+        munmap(map, size);
+        return image;
+    }
+
+    image = wrapImagePixels((char*)map + h->offset, h, filename);
+    image.mapping = map;
+    image.mapSize = size;
+    return image;
+#endif
+}
+
+/**
+ * 建立 width x height 的二進位影像檔，並以 mmap 對應成全零的 Image
+ * 寫入像素即是寫入檔案，freeImage 後檔案內容就完成了，不需要再呼叫 writeImage
+ * 不支援 mmap 的平台會回傳一般的 Image (mapping 為 NULL)，需要另外以 writeImage 寫出
+ *
+ * @param filename 檔案名稱
+ * @param width 寬度
+ * @param height 高度
+ * @return Image 建立失敗時 data 為 NULL
+ */
+static inline Image createImageFile(const char* filename, int width, int height) {
+#if _WIN32 || _WIN64
+    return zerosImage(width, height, filename);
+#else
+    Image image;
+    memset(&image, 0, sizeof(image));
+
+    ImageFileHeader h = makeImageHeader(width, height);
+    size_t size = h.offset + h.stride * height;
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Error opening output file");
+        return image;
+    }
+    if (ftruncate(fd, size) != 0) {  // 新增的部分會填 0
+        perror("Error resizing output file");
+        close(fd);
+        return image;
+    }
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map file");
+        return image;
+    }
+    memcpy(map, &h, sizeof(h));
+
+    image = wrapImagePixels((char*)map + h.offset, &h, filename);
+    image.mapping = map;
+    image.mapSize = size;
+    return image;
+#endif
+}
+
+/**
+ * 將影像寫成二進位格式
+ *
+ * @param filename 檔案名稱
+ * @param image 影像
+ * @return 成功時回傳 0，失敗時回傳 -1
+ */
+static inline int writeBinaryImage(const char* filename, Image image) {
+    ImageFileHeader h = makeImageHeader(image.width, image.height);
+    FILE* file = fopen(filename, "wb");
+    if (!file) return -1;
+
+    int ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    for (int i = 0; i < image.height && ok; i++)
+        ok = fwrite(image.data[i], sizeof(float), image.width, file) == (size_t)image.width;
+    ok = (fclose(file) == 0) && ok;
+    return ok ? 0 : -1;
+}
+
+#endif  // IMAGE_BIN_H
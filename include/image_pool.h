@@ -0,0 +1,39 @@
+#ifndef IMAGE_POOL_H
+#define IMAGE_POOL_H
+#include <cstddef>
+
+#include "image.h"
+
+/**
+ * Image 緩衝區池
+ *
+ * zerosImage 每次都會 malloc 並清零像素與列指標，super sampling 的中間緩衝區與輸出影像在每個工作、
+ * 每個 K 都要重新配置一次。緩衝區池將釋放的緩衝區依 (列寬, 高度) 保留下來，之後相同大小的影像直接重複使用，
+ * 列指標也一起保留，暖機後幾乎不需要再配置記憶體。
+ *
+ * 每一列的起點都對齊 POOL_ALIGN bytes (每列補齊到 POOL_ALIGN 的倍數)，因此 data[i + 1] - data[i] 不一定等於 width。
+ * 設定環境變數 SUPER_HUGE_PAGES=1 時，大於 2 MB 的緩衝區會對齊 2 MB 並要求使用 huge pages (僅 Linux)。
+ * 池中保留的緩衝區總量不超過 SUPER_POOL_LIMIT MB (預設 1024)，超過時直接釋放。
+ *
+ * 從池中取得的影像也可以用 freeImage 釋放 (只是不會被重複使用)。
+ */
+
+#define POOL_ALIGN 64  // 每一列的對齊 (bytes)
+
+/**
+ * 從池中取得一張影像，沒有相同大小的緩衝區時才配置新的
+ *
+ * @param width 寬度
+ * @param height 高度
+ * @param zero 是否清零，所有像素都會被覆寫時可以設為 false 以省去清零的時間
+ * @return 影像 (name 為 NULL)
+ */
+Image acquireImage(int width, int height, bool zero = true);
+
+// 將影像還給池，之後可以被 acquireImage 重複使用；對應到檔案的影像直接以 freeImage 釋放
+void releaseImage(Image& img);
+
+// 釋放池中保留的所有緩衝區
+void trimImagePool();
+
+#endif  // IMAGE_POOL_H
@@ -0,0 +1,146 @@
+#ifndef IMAGE_VIEW_H
+#define IMAGE_VIEW_H
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "image.h"
+#include "image_pool.h"
+
+/**
+ * C++ 的影像型別
+ *
+ * Image 是 C 的結構 (convert.c、display.c 也會使用)，以值傳遞、手動釋放，也無法表示影像的一部分。
+ * ImageView 是不擁有像素的視窗：起點、寬、高與每列的間距 (stride，以 float 為單位)，
+ * 可以指向 Image、ImageBuffer 的一個矩形，或是呼叫端自己的緩衝區，複製 view 不會複製像素。
+ * ImageBuffer 擁有一張影像，只能移動不能複製，解構時自動還給緩衝區池 (image_pool.h)。
+ */
+
+template <typename T>
+struct BasicImageView {
+    T* origin = nullptr;        // 第 0 列第 0 行的像素
+    int width = 0;              // 寬度
+    int height = 0;             // 高度
+    std::ptrdiff_t stride = 0;  // 相鄰兩列的距離 (float 數)，不小於 width
+
+    BasicImageView() = default;
+    BasicImageView(T* origin_, int width_, int height_, std::ptrdiff_t stride_)
+        : origin(origin_), width(width_), height(height_), stride(stride_) {}
+
+    // ImageView 可以轉成 ConstImageView
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    BasicImageView(const BasicImageView<U>& v) : origin(v.origin), width(v.width), height(v.height), stride(v.stride) {}
+
+    // 整張 Image，影像的每一列需要等距排列 (zerosImage、acquireImage、mapImage 配置的影像都是)
+    // img.data 為 NULL 時 (例如讀取或配置失敗) origin 為 nullptr，empty() 為 true
+    explicit BasicImageView(const Image& img)
+        : origin(img.data ? img.data[0] : nullptr),
+          width(img.width),
+          height(img.height),
+          stride(img.data && img.height > 1 ? img.data[1] - img.data[0] : img.width) {}
+
+    T* row(int i) const { return origin + i * stride; }
+    T* operator[](int i) const { return row(i); }
+
+    // 以 (x0, y0) 為左上角、大小為 w x h 的子矩形，不檢查範圍
+    BasicImageView sub(int x0, int y0, int w, int h) const { return {row(y0) + x0, w, h, stride}; }
+
+    bool empty() const { return !origin || width <= 0 || height <= 0; }
+};
+
+using ImageView = BasicImageView<float>;
+using ConstImageView = BasicImageView<const float>;
+
+// 影像中的矩形 (左上角與大小)
+struct ImageRect {
+    int x = 0, y = 0;
+    int width = 0, height = 0;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+};
+
+// 兩張大小相同的影像中，數值不同 (位元不同) 的像素的外接矩形，完全相同時為空矩形
+inline ImageRect image_diff_rect(ConstImageView a, ConstImageView b) {
+    int top = -1, bottom = -1, left = a.width, right = -1;
+    for (int i = 0; i < a.height; i++) {
+        const float *p = a.row(i), *q = b.row(i);
+        if (memcmp(p, q, a.width * sizeof(float)) == 0) continue;
+        if (top < 0) top = i;
+        bottom = i;
+        int j = 0, k = a.width - 1;
+        while (memcmp(p + j, q + j, sizeof(float)) == 0)
+            j++;
+        while (memcmp(p + k, q + k, sizeof(float)) == 0)
+            k--;
+        left = std::min(left, j), right = std::max(right, k);
+    }
+    if (top < 0) return {};
+    return {left, top, right - left + 1, bottom - top + 1};
+}
+
+/**
+ * 將 view 轉成 Image，讓只接受 Image 的函式也能讀寫 view 的像素 (不複製像素)
+ * 只建立列指標，回傳的 Image 不擁有任何記憶體，不可以 freeImage，rows 需在使用期間保持有效
+ *
+ * @param view 影像視窗
+ * @param rows 存放列指標的陣列，會被調整為 view.height 的大小
+ * @return 指向 view 的 Image
+ */
+inline Image view_as_image(ConstImageView view, std::vector<float*>& rows) {
+    rows.resize(view.height);
+    for (int i = 0; i < view.height; i++)
+        rows[i] = const_cast<float*>(view.row(i));
+    return {view.width, view.height, rows.data(), NULL, NULL, NULL, 0};
+}
+
+// 擁有一張影像，只能移動不能複製，解構時自動還給緩衝區池
+class ImageBuffer {
+   public:
+    ImageBuffer() = default;
+    ImageBuffer(int width, int height, bool zero = true) : img(acquireImage(width, height, zero)) {}
+    explicit ImageBuffer(Image image) : img(image) {}  // 接管 C 的 Image (例如 readImage 的結果)
+    ~ImageBuffer() { reset(); }
+
+    ImageBuffer(const ImageBuffer&) = delete;
+    ImageBuffer& operator=(const ImageBuffer&) = delete;
+
+    ImageBuffer(ImageBuffer&& other) noexcept : img(other.img) { other.img = {0, 0, NULL, NULL, NULL, NULL, 0}; }
+    ImageBuffer& operator=(ImageBuffer&& other) noexcept {
+        if (this != &other) reset(), img = other.release();
+        return *this;
+    }
+
+    int width() const { return img.width; }
+    int height() const { return img.height; }
+    explicit operator bool() const { return img.data != NULL; }
+
+    float* operator[](int i) { return img.data[i]; }
+    const float* operator[](int i) const { return img.data[i]; }
+
+    ImageView view() { return ImageView(img); }
+    ConstImageView view() const { return ConstImageView(img); }
+
+    // 借出 C 的 Image 給既有的函式使用，所有權仍在 ImageBuffer
+    Image& image() { return img; }
+    const Image& image() const { return img; }
+
+    // 放棄所有權，由呼叫端負責釋放
+    Image release() {
+        Image out = img;
+        img = {0, 0, NULL, NULL, NULL, NULL, 0};
+        return out;
+    }
+
+    // 釋放影像，之後為空的 ImageBuffer
+    void reset() {
+        if (img.data || img.name) releaseImage(img);
+        img = {0, 0, NULL, NULL, NULL, NULL, 0};
+    }
+
+   private:
+    Image img = {0, 0, NULL, NULL, NULL, NULL, 0};
+};
+
+#endif  // IMAGE_VIEW_H
@@ -5,9 +5,19 @@
 #include <vector>
 
 #include "image.h"
+#include "image_view.h"
+#include "plan.h"
 
 double lagrange(const std::vector<double>& y, double xi);
 
+// 使用重心公式 (barycentric form)
+
+std::vector<double> barycentric_weights(int n);
+
+double lagrange_barycentric(const std::vector<double>& y, double xi);
+
+double lagrange_barycentric(const std::vector<double>& y, double xi, const std::vector<double>& w);
+
 // 使用一般或 overlap 方法
 
 std::pair<int, int> get_block_range(int xi, int N, int K);
@@ -21,6 +31,12 @@ std::pair<int, int> get_sliding_range(int xi, int N, int K);
 
 std::pair<double, double> sliding_row(const Image& src, Image& dst, int blockSize, bool clamped = true);
 
+// 使用預先計算的重取樣計畫
+
+std::pair<double, double> resample_row(const Image& src, Image& dst, const ResamplePlan& plan, bool clamped = true);
+
+std::pair<double, double> resample_col(const Image& src, Image& dst, const ResamplePlan& plan, bool clamped = true);
+
 #define USE_METHOD_BLOCK 0
 #define USE_METHOD_OVERLAP 0x10
 #define USE_METHOD_SLIDING 0x20
@@ -29,5 +45,57 @@ std::pair<double, double> sliding_row(const Image& src, Image& dst, int blockSiz
 #define CLAMP_AT_END 1
 #define NORMALIZE_AT_END 2
 
-void super_sample(const Image& src, Image& dst, int blockSize, int clamping_method = USE_METHOD_SLIDING | CLAMP_AT_END);
+#define USE_BARYCENTRIC 0x100
+#define USE_FLOAT32 0x200
+
+void super_sample(const Image& src, Image& dst, int blockSize, int clamping_method = USE_METHOD_SLIDING | CLAMP_AT_END,
+                  int threads = 0);
+
+void super_sample(const Image& src, Image& dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y,
+                  int clamping = CLAMP_AT_END, int threads = 0);
+
+// 以串流方式只計算第 [row0, row1) 個輸出列，p1、p2 為兩個方向插值的最小值與最大值
+
+void super_sample_rows(const Image& src, Image& dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y,
+                       int clamping, int row0, int row1, std::pair<double, double>& p1,
+                       std::pair<double, double>& p2);
+
+void super_sample_finish(Image& dst, int clamping, const std::vector<std::pair<double, double>>& p1,
+                         const std::vector<std::pair<double, double>>& p2, int threads = 0);
+
+// 使用影像視窗：輸入、輸出可以是影像的一部分或呼叫端的緩衝區，直接寫入 dst 不需要複製
+
+std::pair<double, double> super_row(ConstImageView src, ImageView dst, int blockSize, bool overlap = true,
+                                    bool clamped = true);
+
+std::pair<double, double> sliding_row(ConstImageView src, ImageView dst, int blockSize, bool clamped = true);
+
+void super_sample(ConstImageView src, ImageView dst, int blockSize,
+                  int clamping_method = USE_METHOD_SLIDING | CLAMP_AT_END, int threads = 0);
+
+void super_sample(ConstImageView src, ImageView dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y,
+                  int clamping = CLAMP_AT_END, int threads = 0);
+
+// 區域計算：只計算完整輸出中以 (x0, y0) 為左上角、大小與 dst 相同的矩形，計算量與矩形面積成正比
+// 結果與完整計算的對應像素完全相同；NORMALIZE_AT_END 需要整張影像的最小值、最大值，因此不支援
+
+bool super_sample_region(ConstImageView src, ImageView dst, int x0, int y0, const ResamplePlan& plan_x,
+                         const ResamplePlan& plan_y, int clamping = CLAMP_AT_END, int threads = 0);
+
+bool super_sample_region(ConstImageView src, ImageView dst, int dstWidth, int dstHeight, int x0, int y0,
+                         int blockSize, int method = USE_METHOD_SLIDING | CLAMP_AT_END, int threads = 0);
+
+// 增量計算：dst 是舊的輸入以相同參數計算的結果，輸入只在 dirty 矩形內改變時，只重新計算取樣視窗涵蓋 dirty 的輸出像素
+// updated 傳回重新計算的輸出矩形；NORMALIZE_AT_END 的正規化範圍與整張影像有關，會全部重新計算
+
+bool super_sample_update(ConstImageView src, ImageView dst, ImageRect dirty, const ResamplePlan& plan_x,
+                         const ResamplePlan& plan_y, int clamping = CLAMP_AT_END, int threads = 0,
+                         ImageRect* updated = nullptr);
+
+bool super_sample_update(ConstImageView src, ImageView dst, ImageRect dirty, int blockSize,
+                         int method = USE_METHOD_SLIDING | CLAMP_AT_END, int threads = 0, ImageRect* updated = nullptr);
+
+// 由舊的輸入 prev 與新的輸入 src 比較出 dirty 矩形
+bool super_sample_update(ConstImageView prev, ConstImageView src, ImageView dst, int blockSize,
+                         int method = USE_METHOD_SLIDING | CLAMP_AT_END, int threads = 0, ImageRect* updated = nullptr);
 #endif  // INTERPOLATION_H
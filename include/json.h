@@ -0,0 +1,39 @@
+#ifndef JSON_H
+#define JSON_H
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// 將字串轉成 JSON 字串 (加上引號並跳脫特殊字元)
+inline std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\', out += c;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// 將數值四捨五入到小數點後 digits 位，再以最短的形式輸出 (與 Python 的 json 模組相同，例如 0.00094)
+// JSON 不支援的 nan、inf 輸出為 null
+inline std::string json_number(double x, int digits = 6) {
+    if (!std::isfinite(x)) return "null";
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, x);
+    double rounded = strtod(buf, NULL);
+    auto r = std::to_chars(buf, buf + sizeof(buf), rounded);
+    std::string out(buf, r.ptr);
+    if (out.find_first_of(".e") == std::string::npos) out += ".0";  // 保持浮點數的形式
+    return out;
+}
+
+#endif  // JSON_H
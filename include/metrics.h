@@ -0,0 +1,35 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "image.h"
+
+/**
+ * 影像品質指標 (與參考影像比較)
+ *
+ * 像素值的範圍視為 [0, 1]，PSNR = 10 log10(1 / MSE)。
+ * SSIM 使用 Wang et al. (2004) 的定義：11 x 11、σ = 1.5 的 Gaussian 視窗，K1 = 0.01、K2 = 0.03，
+ * 只計算視窗完全落在影像內的位置 (valid)，再取平均。
+ * 視窗加總以可分離的兩次一維卷積計算，每一列的結果依序相加，因此結果與執行緒數量無關。
+ */
+
+#define SSIM_RADIUS 5   // 視窗半徑 (11 x 11)
+#define SSIM_SIGMA 1.5  // Gaussian 視窗的標準差
+#define SSIM_K1 0.01
+#define SSIM_K2 0.03
+
+struct ImageMetrics {
+    double mse;
+    double psnr;  // MSE 為 0 時為 inf
+    double ssim;
+};
+
+// 均方誤差，兩張影像大小需相同
+double image_mse(const Image& a, const Image& b, int threads = 0);
+
+// 平均 SSIM，兩張影像大小需相同；影像小於視窗時會縮小視窗
+double image_ssim(const Image& a, const Image& b, int threads = 0);
+
+// 計算 MSE、PSNR、SSIM，大小不同時回傳 false
+bool compare_images(const Image& a, const Image& b, ImageMetrics& result, int threads = 0);
+
+#endif  // METRICS_H
@@ -0,0 +1,42 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// 預設的執行緒數量 (CPU 核心數)
+inline int default_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+/**
+ * 將 [begin, end) 切成最多 threads 段，平行執行 f(lo, hi)
+ * 每一段的起點都會對齊 grain 的倍數 (相對於 begin)，最後一段由呼叫端的執行緒執行
+ *
+ * @param begin 起點
+ * @param end 終點
+ * @param grain 切割的最小單位
+ * @param threads 執行緒數量，0 表示使用 default_threads()
+ * @param f 要執行的函式，參數為 (lo, hi)
+ */
+template <typename F>
+void parallel_for(int begin, int end, int grain, int threads, F&& f) {
+    if (threads <= 0) threads = default_threads();
+    int units = (end - begin + grain - 1) / grain;  // 總共有幾個單位
+    threads = std::max(1, std::min(threads, units));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        int lo = begin + (long long)units * t / threads * grain;
+        int hi = std::min(end, begin + (int)((long long)units * (t + 1) / threads) * grain);
+        if (t == threads - 1)
+            f(lo, hi);
+        else
+            workers.emplace_back([&f, lo, hi] { f(lo, hi); });
+    }
+    for (auto& w : workers)
+        w.join();
+}
+
+#endif  // PARALLEL_H
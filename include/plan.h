@@ -0,0 +1,51 @@
+#ifndef PLAN_H
+#define PLAN_H
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * 一維重取樣計畫
+ *
+ * 將長度 N 的訊號插值為長度 M 時，每個輸出位置的取樣視窗與 Lagrange 權重只與位置本身有關，
+ * 與影像內容無關。因此預先計算一次，之後每一列、每一個 pass 都只需要做一次內積。
+ *
+ * 為了讓所有輸出位置的視窗長度一致，較短的視窗會以 0 權重補齊到 taps 個點。
+ * 由於 N / M 是有理數，權重會週期性地重複，因此只儲存不同的權重 (相位)，每個輸出位置記錄自己的相位編號。
+ */
+struct ResamplePlan {
+    int N = 0;       // 輸入長度
+    int M = 0;       // 輸出長度
+    int K = 0;       // 區塊大小
+    int method = 0;  // 取樣方法 (USE_METHOD_*，可附加 USE_BARYCENTRIC、USE_FLOAT32)
+    int taps = 0;    // 每個輸出位置使用的取樣點數
+
+    std::vector<int> start;        // 每個輸出位置的視窗起點，大小為 M
+    std::vector<int> phase;        // 每個輸出位置使用的相位編號，大小為 M
+    std::vector<double> weights;   // 每個相位的權重，大小為 phases() * taps
+    std::vector<float> weights_f;  // weights 的單精度版本，只有帶 USE_FLOAT32 的計畫才會建立
+
+    ResamplePlan() = default;
+    ResamplePlan(int srcSize, int dstSize, int blockSize, int methodCode);
+
+    // 不同相位的數量
+    int phases() const { return taps ? weights.size() / taps : 0; }
+
+    // 第 j 個輸出位置的權重，T 為 double 或 float
+    template <typename T = double>
+    const T* weight(int j) const {
+        if constexpr (std::is_same_v<T, float>)
+            return weights_f.data() + (size_t)phase[j] * taps;
+        else
+            return weights.data() + (size_t)phase[j] * taps;
+    }
+
+    // 由 weights 產生單精度的權重 (只在 method 帶有 USE_FLOAT32 時建立，雙精度的計畫不保留這份副本)
+    void update_float_weights();
+
+    // 第 [j0, j0 + count) 個輸出位置的子計畫 (區域計算用)，權重與原本的計畫相同
+    // 只保留這些位置會讀取的輸入範圍 [first, first + N)，start 改以 first 為原點，first 由參數傳回
+    ResamplePlan slice(int j0, int count, int& first) const;
+};
+
+#endif  // PLAN_H
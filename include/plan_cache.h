@@ -0,0 +1,29 @@
+#ifndef PLAN_CACHE_H
+#define PLAN_CACHE_H
+#include <string>
+
+#include "plan.h"
+
+/**
+ * 重取樣計畫的磁碟快取
+ *
+ * 設定環境變數 SUPER_PLAN_CACHE 為一個資料夾後，計畫會以 (N, M, K, method, 純量型別) 為鍵值存成檔案，
+ * 之後的程序直接以 mmap 讀取。若要放在共享記憶體中，可以將資料夾設為 /dev/shm 底下的路徑。
+ *
+ * 檔案內容為計畫的週期 (polyphase) 壓縮形式：各相位的權重、前一個週期的 (起點, 相位)，
+ * 以及不符合週期規律的例外位置，因此檔案大小與 M 幾乎無關。檔案以 checksum 驗證。
+ */
+
+// 快取檔案名稱
+std::string plan_cache_name(int N, int M, int K, int method);
+
+// 讀取快取檔案，鍵值不符或檔案損毀時回傳 false
+bool read_plan_cache(const char* filename, ResamplePlan& plan, int N, int M, int K, int method);
+
+// 寫入快取檔案，失敗時回傳 false
+bool write_plan_cache(const char* filename, const ResamplePlan& plan);
+
+// 取得重取樣計畫，有設定 SUPER_PLAN_CACHE 時會優先使用快取
+ResamplePlan get_plan(int N, int M, int K, int method);
+
+#endif  // PLAN_CACHE_H
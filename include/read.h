@@ -3,13 +3,25 @@
 #include <stdio.h>
 
 #include "image.h"
+#include "image_bin.h"
+#ifdef __cplusplus
+  #include "text_io.h"
+  #include "tiled.h"
+#endif
 
 // 從檔案讀取影像資料
-static Image readImage(const char* filename) {
+static inline Image readImage(const char* filename) {
+    if (isBinaryImage(filename)) return mapImage(filename);  // 二進位格式直接以 mmap 開啟
+#ifdef __cplusplus
+    if (isTiledImage(filename)) return readTiledImage(filename);  // 分塊格式 (tiled.h)
+    return readTextImage(filename);  // C++ 使用平行解析的版本 (text_io.h)
+#else
     Image image;
     image.name = NULL;  // ?w?]?????
     image.data = NULL;
     image.buffer = NULL;
+    image.mapping = NULL;
+    image.mapSize = 0;
     image.width = image.height = 0;
 
     FILE* file = fopen(filename, "r");
@@ -34,6 +46,7 @@ static Image readImage(const char* filename) {
             if (fscanf(file, "%f", &image.data[i][j]) != 1) {
                 fprintf(stderr, "Invalid pixel data at row %d, col %d\n", i, j);
                 freeImage(image);
+                image.data = NULL;
                 fclose(file);
                 return image;
             }
@@ -42,6 +55,7 @@ static Image readImage(const char* filename) {
 
     fclose(file);
     return image;  //  ???????^??A???? malloc Image ???c
+#endif
 }
 
 #endif
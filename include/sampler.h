@@ -0,0 +1,89 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "image_view.h"
+#include "interpolation.h"
+#include "plan.h"
+
+/**
+ * 逐點查詢的 super sampling
+ *
+ * 不建立輸出影像，sample(x, y) 時才計算輸出影像的一個像素：行方向的取樣視窗需要 taps 個中間列，
+ * 每個中間列在 x 的值是列方向插值的結果。中間列以 SAMPLER_CHUNK 個輸出行為一段計算，
+ * 並放在快取中，因此空間上連續的查詢 (例如逐列掃描或小範圍的查詢) 幾乎不需要重新計算。
+ * 結果與 super_sample 對應的像素完全相同，不支援 NORMALIZE_AT_END (需要整張影像的最小值、最大值)。
+ *
+ * sample 可以由多個執行緒同時呼叫。快取依 (段, 列區塊) 分成 SAMPLER_SHARDS 個分片，各自以讀寫鎖保護：
+ * 命中時只需要共享鎖，並以 CLOCK 演算法近似 LRU (命中只設定參考位元，不移動任何節點)；
+ * 計算中間列時不持有鎖，放進快取時才取得該分片的獨占鎖。
+ */
+
+#define SAMPLER_CHUNK 64       // 每段中間列的輸出行數
+#define SAMPLER_SHARDS 16      // 快取的分片數
+#define SAMPLER_SHARD_ROWS 16  // 同一段中連續 SAMPLER_SHARD_ROWS 個中間列放在同一個分片
+#define SAMPLER_MAX_TAPS 128   // 取樣點數不超過此值時，查詢只使用堆疊上的空間
+
+class PointSampler {
+   public:
+    /**
+     * @param src 輸入影像，需在 PointSampler 使用期間保持有效
+     * @param dstWidth 輸出影像的寬度
+     * @param dstHeight 輸出影像的高度
+     * @param blockSize 區塊大小 (K)
+     * @param method 計算方法，與 super_sample 相同
+     * @param cacheChunks 快取的中間列段數上限 (平均分給各分片)
+     */
+    PointSampler(ConstImageView src, int dstWidth, int dstHeight, int blockSize,
+                 int method = USE_METHOD_SLIDING | CLAMP_AT_END, size_t cacheChunks = 4096);
+
+    PointSampler(const PointSampler&) = delete;
+    PointSampler& operator=(const PointSampler&) = delete;
+
+    // 參數錯誤或使用 NORMALIZE_AT_END 時為 false
+    bool ok() const { return valid; }
+
+    int width() const { return plan_x.M; }
+    int height() const { return plan_y.M; }
+
+    // 輸出影像第 y 列第 x 行的像素，超出範圍時回傳 0
+    float sample(int x, int y);
+
+    // 快取命中、未命中的次數 (以中間列段計算)
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+   private:
+    struct Entry {
+        std::vector<float> values;           // 中間列的一段
+        std::atomic<bool> referenced{true};  // CLOCK 的參考位元，命中時設定
+    };
+
+    // 快取的一個分片，對齊到 cache line 避免不同分片的鎖互相干擾
+    struct alignas(64) Shard {
+        std::shared_mutex lock;
+        std::unordered_map<int64_t, Entry> cache;  // 鍵為 (中間列, 段) 編碼成的整數
+        std::vector<int64_t> ring;                 // CLOCK 的環形佇列
+        size_t hand = 0;                           // CLOCK 的指針
+        std::atomic<uint64_t> hit_count{0}, miss_count{0};
+    };
+
+    ConstImageView src;
+    ResamplePlan plan_x, plan_y;
+    int clamping = 0;
+    bool valid = false;
+
+    size_t capacity;  // 每個分片的段數上限
+    Shard shards[SAMPLER_SHARDS];
+
+    int shard_of(int row, int chunk) const;
+    void insert(Shard& shard, int64_t key, std::vector<float>&& values);
+    std::vector<float> compute_chunk(int row, int chunk) const;
+};
+
+#endif  // SAMPLER_H
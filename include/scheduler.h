@@ -0,0 +1,60 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing 工作排程器
+ *
+ * 每個執行緒都有自己的工作佇列：在執行緒內提交的工作放進自己佇列的尾端並優先執行 (LIFO)，
+ * 自己的佇列空了就從其他執行緒佇列的前端偷工作 (FIFO)。
+ * 大工作可以在執行時再切成小工作提交，閒置的執行緒會自動把它們偷走，讓所有核心保持忙碌。
+ */
+class TaskScheduler {
+   public:
+    using Task = std::function<void()>;
+
+    explicit TaskScheduler(int threads = 0);  // threads 為 0 時使用所有核心
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // 提交工作，可以在工作中呼叫
+    void submit(Task task);
+
+    // 等待所有工作 (包含執行中產生的工作) 完成，不可以在工作中呼叫
+    void wait();
+
+    // 執行緒數量
+    int size() const { return workers.size(); }
+
+   private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;  // 每個執行緒的工作佇列
+    std::vector<std::thread> workers;
+
+    std::atomic<int> queued{0};     // 佇列中的工作數量
+    std::atomic<int> pending{0};    // 尚未完成的工作數量 (佇列中 + 執行中)
+    std::atomic<unsigned> next{0};  // 外部提交時輪流放入的佇列
+    bool stopping = false;
+
+    std::mutex sleep_lock;
+    std::condition_variable wake;  // 有新工作或要結束時通知
+    std::condition_variable idle;  // 所有工作完成時通知
+
+    bool pop(int self, Task& task);
+    void run(int self);
+};
+
+#endif  // SCHEDULER_H
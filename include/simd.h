@@ -0,0 +1,42 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/**
+ * SIMD 向量型別
+ *
+ * 使用 GCC / Clang 的 vector extension，由編譯器依照目標平台產生 AVX、SSE 或 NEON 指令，
+ * 不支援的平台會自動退回純量運算。
+ * 未開啟 AVX 時 GCC 會提示 32 bytes 向量參數的 ABI 差異 (-Wpsabi)，這些函式都會被 inline，
+ * 因此 makefile 只對使用向量的檔案加上 -Wno-psabi。
+ */
+
+#define SIMD_BYTES 32  // 一個向量的大小 (AVX2 暫存器)
+
+// 純量型別 T 對應的向量型別，double 為 4 個 lane，float 為 8 個 lane
+template <typename T>
+struct Simd {
+    typedef T vec __attribute__((vector_size(SIMD_BYTES)));
+    static constexpr int LANES = SIMD_BYTES / sizeof(T);
+};
+
+template <typename T>
+using vec_t = typename Simd<T>::vec;
+
+// 逐 lane 取最大值、最小值
+template <typename V>
+inline V vmax(V a, V b) {
+    return a > b ? a : b;
+}
+template <typename V>
+inline V vmin(V a, V b) {
+    return a < b ? a : b;
+}
+
+// 逐 lane 限制在 [0, 1] 範圍內
+template <typename V>
+inline V vclamp(V x) {
+    V zero = x - x, one = zero + 1;
+    return vmin(vmax(x, zero), one);
+}
+
+#endif  // SIMD_H
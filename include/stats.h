@@ -0,0 +1,76 @@
+#ifndef STATS_H
+#define STATS_H
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * 各階段的計時器與計數器 (./super --stats)
+ *
+ * 預設為停用：計時器只多一次分支判斷，不會讀取時鐘，計數器也不會被更新。
+ * 啟用時每個計時區段結束後以 atomic 累加到全域的統計，計時的單位是一次讀檔、一個批次或一個輸出列，
+ * 相對於區段內的計算量，讀取時鐘與累加的成本可以忽略。
+ * 各階段的時間是所有執行緒的總和，多執行緒時可能大於實際經過的時間。
+ */
+
+enum Stage {
+    STAGE_READ,       // readImage (串流模式為逐列讀取)
+    STAGE_ROW_PASS,   // 列方向插值
+    STAGE_TRANSPOSE,  // 轉置 (transpose_image)
+    STAGE_COL_PASS,   // 行方向插值
+    STAGE_CLAMP,      // 最後的 clamp 或正規化
+    STAGE_WRITE,      // writeImage (串流模式為逐列寫出)
+    STAGE_COUNT
+};
+
+enum Counter {
+    PIXELS_PRODUCED,     // 輸出的像素數
+    WINDOW_RELOADS,      // 取樣視窗移動的次數 (相鄰輸出位置的視窗起點不同，left != last_left)
+    BYTES_READ,          // 讀取的檔案大小
+    BYTES_WRITTEN,       // 寫出的檔案大小
+    BUFFER_ALLOCATIONS,  // 緩衝區池新配置的影像數 (image_pool.h)
+    BUFFER_REUSES,       // 緩衝區池重複使用的影像數
+    COUNTER_COUNT
+};
+
+// 是否啟用統計，需在開始計算前設定
+extern bool stats_enabled;
+
+// 目前的時間 (ns)
+inline uint64_t stats_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 將一次執行的時間加到階段 stage
+void stats_add_time(Stage stage, uint64_t ns);
+
+// 將計數器 counter 加上 n
+void stats_add(Counter counter, uint64_t n);
+
+// 將檔案大小加到計數器 counter (BYTES_READ 或 BYTES_WRITTEN)，檔案不存在時不計算
+void stats_add_file(Counter counter, const char* filename);
+
+// 更新 clamp 前的最小值、最大值
+void stats_excursion(double mn, double mx);
+
+// 以 JSON 輸出所有統計，wall_ns 為整個程式實際經過的時間
+std::string stats_json(uint64_t wall_ns);
+
+// 計時一個區段，建構時開始，解構時將經過的時間加到對應的階段
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(Stage which) : stage(which), start(stats_enabled ? stats_now() : 0) {}
+    ~ScopedTimer() {
+        if (start) stats_add_time(stage, stats_now() - start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+   private:
+    Stage stage;
+    uint64_t start;  // 0 表示未啟用
+};
+
+#endif  // STATS_H
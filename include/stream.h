@@ -0,0 +1,99 @@
+#ifndef STREAM_H
+#define STREAM_H
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "tiled.h"
+
+/**
+ * 記憶體用量有上限的串流 super sampling
+ *
+ * 輸入影像一列一列讀進一個滑動視窗，輸出影像以固定高度的區帶 (band) 計算，
+ * 每個區帶完成後立即附加到輸出檔案，因此記憶體用量與 M² 無關，可以輸出比記憶體還大的影像。
+ * 文字、二進位與分塊格式都支援，輸入依 magic number 判斷，輸出依副檔名決定。
+ */
+
+// 依序讀取影像的每一列，不需要將整張影像放在記憶體中
+class ImageRowReader {
+   public:
+    explicit ImageRowReader(const char* filename);  // 失敗時印出錯誤訊息，ok() 為 false
+    ~ImageRowReader();
+
+    ImageRowReader(const ImageRowReader&) = delete;
+    ImageRowReader& operator=(const ImageRowReader&) = delete;
+
+    bool ok() const { return file != NULL || (tiled && tiled->ok()); }
+
+    // 讀取下一列 (width 個像素)，失敗時印出與 readImage 相同的錯誤訊息並回傳 false
+    bool read_row(float* row);
+
+    int width = 0, height = 0;
+    int tile = 0;  // 分塊格式的區塊大小，其他格式為 0
+
+   private:
+    FILE* file = NULL;
+    std::string name;
+    bool binary = false;
+    int row = 0;  // 下一個要讀取的列
+
+    // 二進位格式
+    uint64_t stride = 0;
+
+    // 分塊格式，一次解碼一列區塊
+    std::unique_ptr<TiledImageReader> tiled;
+    std::vector<float> tile_rows;
+
+    // 文字格式的讀取緩衝區，[pos, len) 是尚未解析的部分
+    std::vector<char> buf;
+    size_t pos = 0, len = 0;
+    bool eof = false;
+
+    bool next_token(const char*& begin, const char*& end);
+};
+
+// 依序將影像的列附加到檔案，*.bin 寫成二進位格式，*.tiles 寫成分塊格式，其他寫成文字格式
+class ImageRowWriter {
+   public:
+    ImageRowWriter(const char* filename, int width, int height);  // 失敗時印出錯誤訊息，ok() 為 false
+    ~ImageRowWriter();
+
+    ImageRowWriter(const ImageRowWriter&) = delete;
+    ImageRowWriter& operator=(const ImageRowWriter&) = delete;
+
+    bool ok() const { return tiled ? tiled->ok() : file != NULL && good; }
+
+    // 附加 image 的第 [row0, row1) 列
+    bool write_rows(const Image& image, int row0, int row1, int threads = 0);
+
+    // 關閉檔案，回傳所有寫入是否成功
+    bool close();
+
+   private:
+    FILE* file = NULL;
+    bool binary = false;
+    bool good = true;
+    std::unique_ptr<TiledImageWriter> tiled;
+};
+
+/**
+ * 以串流方式進行 super sampling，輸入與輸出都直接在檔案上進行
+ *
+ * @param srcFilename 輸入檔案
+ * @param dstFilename 輸出檔案
+ * @param dstWidth 輸出寬度
+ * @param dstHeight 輸出高度
+ * @param blockSize 區塊大小 (K)
+ * @param method 計算方法 (同 super_sample)
+ * @param memoryLimit 記憶體用量上限 (bytes)
+ * @param threads 執行緒數量，0 表示使用所有核心
+ * @return 是否成功
+ */
+bool super_sample_stream(const char* srcFilename, const char* dstFilename, int dstWidth, int dstHeight,
+                         int blockSize, int method, size_t memoryLimit, int threads = 0);
+
+#endif  // STREAM_H
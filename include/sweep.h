@@ -0,0 +1,45 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "metrics.h"
+
+/**
+ * 參數掃描：對每個 (方法, K, clamp 時機) 組合進行 super sampling，並與參考影像比較
+ *
+ * 輸入與參考影像只讀取一次，所有組合由排程器平行執行，輸出影像只存在記憶體中，計算完立即比較並釋放。
+ * 結果寫成與 compare.py 相同格式的 JSON (<dir>/<method>_<clamp>.json，內容為 MSE、PSNR、SSIM 對 K 的對應)。
+ */
+
+struct SweepResult {
+    int method;  // 區塊選擇方法 (USE_METHOD_*) | clamp 時機
+    int k;
+    ImageMetrics metrics;
+};
+
+/**
+ * 執行參數掃描
+ *
+ * @param src 輸入影像
+ * @param ref 參考影像，輸出影像的大小與參考影像相同
+ * @param methods 要測試的方法 (USE_METHOD_* | clamp 時機)
+ * @param ks 要測試的 K 值
+ * @param threads 執行緒數量，0 表示使用所有核心
+ * @return 每個組合的結果，依 methods、ks 的順序排列
+ */
+std::vector<SweepResult> sweep(const Image& src, const Image& ref, const std::vector<int>& methods,
+                               const std::vector<int>& ks, int threads = 0);
+
+// 方法的名稱 (block、overlap、sliding)，即 JSON 檔名的前半部分
+const char* method_name(int method);
+
+/**
+ * 將結果依方法分別寫成 JSON 檔案 (<dir>/<method>_<clamp>.json)
+ *
+ * @return 是否全部寫入成功
+ */
+bool write_sweep_json(const std::vector<SweepResult>& results, const std::string& dir);
+
+#endif  // SWEEP_H
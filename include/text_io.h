@@ -0,0 +1,29 @@
+#ifndef TEXT_IO_H
+#define TEXT_IO_H
+
+#include <cstdio>
+
+#include "image.h"
+
+/**
+ * 文字格式影像 (*.txt) 的快速讀寫
+ *
+ * 檔案以 mmap 開啟後切成數個以換行對齊的區段平行解析，每個像素以 std::from_chars 轉換，
+ * 結果與 fscanf("%f") 相同，錯誤訊息也與 read.h 相同。
+ * 寫出時以 std::to_chars 平行格式化數個列區塊，再以少數幾次大的寫入交給檔案，輸出與 fprintf("%.6f") 完全相同。
+ */
+
+// 讀取文字格式的影像，threads 為 0 時使用所有核心；讀取失敗時 data 為 NULL
+Image readTextImage(const char* filename, int threads = 0);
+
+// 將影像寫成文字格式，threads 為 0 時使用所有核心；失敗時印出錯誤訊息並回傳 false
+bool writeTextImage(const char* filename, const Image& image, int threads = 0);
+
+// 以文字格式將第 [row0, row1) 列寫到已開啟的檔案 (不含標頭)，用於分段輸出
+bool write_text_rows(FILE* file, const Image& image, int row0, int row1, int threads = 0);
+
+// 解析 p 開頭的一個數值 (允許開頭的 '+')，數值之後必須是空白或 end，成功時 p 移到數值之後
+bool parse_text_value(const char*& p, const char* end, float& value);
+bool parse_text_value(const char*& p, const char* end, int& value);
+
+#endif  // TEXT_IO_H
@@ -0,0 +1,115 @@
+#ifndef TILED_H
+#define TILED_H
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "image.h"
+
+/**
+ * 分塊 (tiled) 影像格式 (*.tiles)
+ *
+ * 影像切成 tile x tile 的區塊，每個區塊獨立儲存 (可選擇以差分 + 位元組重排 + RLE 無失真壓縮)，
+ * 檔案結尾的索引記錄每個區塊的位置，因此可以平行編碼、解碼，也可以只讀取涵蓋某個矩形的區塊。
+ *
+ * 檔案內容：64 bytes 的標頭、依列優先順序排列的區塊資料、區塊索引 (每個區塊的位置、大小、編碼方式)
+ */
+
+#define TILE_SIZE 256  // 預設的區塊大小
+#define TILED_VERSION 1
+
+#define TILE_RAW 0         // 區塊直接存放 float32 像素
+#define TILE_COMPRESSED 1  // 區塊以差分 + 位元組重排 + RLE 壓縮
+
+static const char TILED_MAGIC[8] = {'S', 'S', 'T', 'I', 'L', 'E', 'S', '\0'};
+
+struct TiledFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;  // 與二進位格式相同，目前只支援 float32
+    int32_t width, height;
+    int32_t tile;          // 區塊的邊長，右邊與下邊的區塊可能比較小
+    uint32_t compression;  // 寫入時是否嘗試壓縮 (僅供參考，每個區塊的編碼方式記錄在索引中)
+    uint64_t index;        // 區塊索引在檔案中的位置
+    uint8_t reserved[24];
+};
+
+struct TileEntry {
+    uint64_t offset;  // 區塊資料在檔案中的位置
+    uint32_t size;    // 區塊資料的大小 (bytes)
+    uint32_t codec;   // TILE_RAW 或 TILE_COMPRESSED
+};
+
+static_assert(sizeof(TiledFileHeader) == 64, "TiledFileHeader must be 64 bytes");
+static_assert(sizeof(TileEntry) == 16, "TileEntry must be 16 bytes");
+
+struct FileContents;
+
+// 讀取分塊影像，檔案以 mmap 開啟，可以同時讀取多個區域
+class TiledImageReader {
+   public:
+    explicit TiledImageReader(const char* filename);  // 失敗時印出錯誤訊息，ok() 為 false
+    ~TiledImageReader();
+
+    bool ok() const { return index != nullptr; }
+
+    // 讀取左上角為 (x0, y0)、大小為 dst.width x dst.height 的區域，只解碼涵蓋這個區域的區塊
+    bool read_region(int x0, int y0, Image& dst, int threads = 0) const;
+
+    int width = 0, height = 0, tile = 0;
+
+   private:
+    std::unique_ptr<FileContents> file;
+    const TileEntry* index = nullptr;
+    int tiles_x = 0, tiles_y = 0;
+
+    bool decode(int tx, int ty, float* out) const;
+};
+
+// 依序寫出分塊影像，每累積一列區塊就平行編碼並寫出，記憶體用量只有一列區塊
+class TiledImageWriter {
+   public:
+    TiledImageWriter(const char* filename, int width, int height, int tile = TILE_SIZE, bool compress = true);
+    ~TiledImageWriter();
+
+    TiledImageWriter(const TiledImageWriter&) = delete;
+    TiledImageWriter& operator=(const TiledImageWriter&) = delete;
+
+    bool ok() const { return file != NULL && good; }
+
+    // 依序附加 image 的第 [row0, row1) 列
+    bool write_rows(const Image& image, int row0, int row1, int threads = 0);
+
+    // 寫出區塊索引並關閉檔案，回傳所有寫入是否成功
+    bool close();
+
+   private:
+    FILE* file = NULL;
+    int width, height, tile, tiles_x;
+    bool compress, good = true;
+    int rows = 0;                        // 已經收到的列數
+    std::vector<float> pending;          // 還沒寫出的一列區塊 (tile 列)
+    std::vector<TileEntry> tiles;        // 已經寫出的區塊
+    uint64_t offset = 0;                 // 下一個區塊在檔案中的位置
+
+    bool flush(int threads);
+};
+
+// 檔案是否為分塊影像格式
+bool isTiledImage(const char* filename);
+
+// 檔名是否以 .tiles 結尾，寫出影像時用來決定格式
+bool hasTiledExtension(const char* filename);
+
+// 讀取整張分塊影像，失敗時 data 為 NULL
+Image readTiledImage(const char* filename, int threads = 0);
+
+// 讀取左上角為 (x0, y0)、大小為 width x height 的區域，只解碼涵蓋這個區域的區塊，失敗時 data 為 NULL
+Image readTiledRegion(const char* filename, int x0, int y0, int width, int height, int threads = 0);
+
+// 將影像寫成分塊格式，失敗時印出錯誤訊息並回傳 false
+bool writeTiledImage(const char* filename, const Image& image, int tile = TILE_SIZE, bool compress = true,
+                     int threads = 0);
+
+#endif  // TILED_H
@@ -0,0 +1,9 @@
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H
+
+#include "image.h"
+
+// 平行轉置影像，結果寫入 dst (大小需為 src.height x src.width)，threads 為 0 時使用所有核心
+bool transpose_image(const Image& src, Image& dst, int threads = 0);
+
+#endif  // TRANSPOSE_H
@@ -4,8 +4,27 @@
 #include <stdlib.h>
 
 #include "image.h"
+#include "image_bin.h"
+#ifdef __cplusplus
+  #include "text_io.h"
+  #include "tiled.h"
+#endif
 
 void writeImage(const char* filename, Image image) {
+    if (hasBinaryExtension(filename)) {  // *.bin 寫成二進位格式
+        if (writeBinaryImage(filename, image) != 0) {
+            perror("Error writing output file");
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+#ifdef __cplusplus
+    if (hasTiledExtension(filename)) {  // *.tiles 寫成分塊格式 (tiled.h)
+        if (!writeTiledImage(filename, image)) exit(EXIT_FAILURE);
+        return;
+    }
+    if (!writeTextImage(filename, image)) exit(EXIT_FAILURE);  // C++ 使用平行格式化的版本 (text_io.h)
+#else
     FILE* file = fopen(filename, "w");
     if (!file) {
         perror("Error opening output file");
@@ -23,6 +42,7 @@ void writeImage(const char* filename, Image image) {
         fprintf(file, "\n");
     }
     fclose(file);
+#endif
 }
 
 #endif
@@ -2,6 +2,7 @@
 #include "interpolation.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iomanip>
 #include <iostream>
@@ -9,6 +10,12 @@
 #include <vector>
 
 #include "image.h"
+#include "image_pool.h"
+#include "parallel.h"
+#include "plan.h"
+#include "plan_cache.h"
+#include "simd.h"
+#include "stats.h"
 #include "utils.h"
 
 /**
@@ -30,6 +37,65 @@ double lagrange(const std::vector<double>& ys, double xi) {
     return ret;
 }
 
+/**
+ * 計算等距取樣點 0, 1, ..., n - 1 的重心權重 (barycentric weights)
+ * w[i] = (-1)^i * C(n - 1, i)，常數倍數在計算時會被約掉
+ *
+ * @param n 取樣點數
+ * @return 重心權重
+ */
+std::vector<double> barycentric_weights(int n) {
+    std::vector<double> w(n);
+    if (n > 0) w[0] = 1.0;
+    for (int i = 1; i < n; i++)
+        w[i] = -w[i - 1] * (n - i) / i;
+    return w;
+}
+
+/**
+ * 拉格朗日插值法 (重心公式)
+ * 與 lagrange() 結果相同，但只需要 O(K) 的計算量
+ * 重心權重在每次呼叫時重新計算，對相同的取樣點數重複插值時請改用傳入權重的版本
+ *
+ * @param ys 取樣點陣列
+ * @param xi 要插值的點
+ * @return 插值結果
+ */
+double lagrange_barycentric(const std::vector<double>& ys, double xi) {
+    int n = ys.size();
+    double num = 0.0, den = 0.0;  // 分子、分母
+    double w = 1.0;               // 第 i 個重心權重，以遞迴方式計算
+
+    for (int i = 0; i < n; i++) {
+        if (xi == i) return ys[i];  // 剛好落在取樣點上
+        double term = w / (xi - i);
+        num += term * ys[i], den += term;
+        w = -w * (n - 1 - i) / (i + 1);
+    }
+    return num / den;
+}
+
+/**
+ * 拉格朗日插值法 (重心公式，使用預先計算的重心權重)
+ * 結果與 lagrange_barycentric(ys, xi) 完全相同
+ *
+ * @param ys 取樣點陣列
+ * @param xi 要插值的點
+ * @param w 重心權重 (barycentric_weights(ys.size()))
+ * @return 插值結果
+ */
+double lagrange_barycentric(const std::vector<double>& ys, double xi, const std::vector<double>& w) {
+    int n = ys.size();
+    double num = 0.0, den = 0.0;  // 分子、分母
+
+    for (int i = 0; i < n; i++) {
+        if (xi == i) return ys[i];  // 剛好落在取樣點上
+        double term = w[i] / (xi - i);
+        num += term * ys[i], den += term;
+    }
+    return num / den;
+}
+
 /**********************************************************************************************************************/
 
 /**
@@ -60,42 +126,8 @@ std::pair<int, int> get_block_range(int x, int N, int K) {
  * @return std::pair<double, double> 計算出的最小值與最大值
  */
 std::pair<double, double> super_row(const Image& src, Image& dst, int blockSize, bool overlap, bool clamped) {
-    blockSize = src.width / (src.width / blockSize);  // 調整 blockSize 的大小，使每個區塊儘量均勻
-
-    double scale = (double)src.width / dst.width;  // [0, M) -> [0, N) 的縮放比例
-    double mx = 1.0, mn = 0.0;                     // 記錄最大值、最小值
-
-    for (int i = 0; i < dst.height; i++) {
-        int last_left = -1;      // 上一次的 left 位置
-        std::vector<double> ys;  // 插值的取樣點
-
-        for (int j = 0; j < dst.width; j++) {
-            double xi = j * scale;  // 在原始影像中的位置
-
-            auto [left, right] = get_block_range((int)xi, src.width, blockSize);  // 取樣區塊的範圍
-
-            if (overlap) {                       // 使用 overlap 方式
-                if (left > 0) left--;            // 向左擴展取樣範圍
-                if (right < src.width) right++;  // 向右擴展取樣範圍
-            }
-
-            if (left != last_left) {  // 更新取樣點 (如有需要)
-                ys.resize(right - left);
-                for (int jj = 0, l = left; l < right; jj++, l++) {
-                    ys[jj] = src.data[i][l];
-                }
-                last_left = left;
-            }
-
-            double value = lagrange(ys, xi - left);
-            if (clamped) value = clamp(value);
-            mx = std::max(mx, value), mn = std::min(mn, value);
-
-            dst.data[i][j] = value;
-        }
-    }
-
-    return {mn, mx};
+    ResamplePlan plan(src.width, dst.width, blockSize, overlap ? USE_METHOD_OVERLAP : USE_METHOD_BLOCK);
+    return resample_row(src, dst, plan, clamped);
 }
 
 /**********************************************************************************************************************/
@@ -127,38 +159,343 @@ std::pair<int, int> get_sliding_range(int xi, int N, int K) {
  * @return std::pair<double, double> 計算出的最小值與最大值
  */
 std::pair<double, double> sliding_row(const Image& src, Image& dst, int blockSize, bool clamped) {
-    double scale = (double)src.width / dst.width;  // [0, M) -> [0, N) 的縮放比例
-    double mx = 1.0f, mn = 0.0f;                   // 記錄最大值、最小值
+    ResamplePlan plan(src.width, dst.width, blockSize, USE_METHOD_SLIDING);
+    return resample_row(src, dst, plan, clamped);
+}
 
-    for (int i = 0; i < dst.height; i++) {
-        int last_left = -1;                 // 上一次的 left 位置
-        std::vector<double> ys(blockSize);  // 插值的取樣點
+/**********************************************************************************************************************/
+
+// 列方向插值時一次處理的列數 (兩個向量)
+template <typename T>
+constexpr int row_batch() {
+    return 2 * Simd<T>::LANES;
+}
+
+/**
+ * 列方向插值的核心：計算 dst 的第 [row0, row1) 列
+ *
+ * @tparam T 計算使用的純量型別 (double 或 float)
+ * @tparam TAPS 取樣點數，0 表示執行時才決定 (使用 plan.taps)
+ * @tparam CLAMPED 是否將結果限制在 [0, 1]
+ * @param src 輸入影像，寬度需為 plan.N
+ * @param dst 輸出影像，寬度需為 plan.M
+ * @param plan 重取樣計畫
+ * @param row0 起始列
+ * @param row1 結束列 (不含)
+ * @param p 目前的最小值與最大值，會被更新
+ */
+template <typename T, int TAPS, bool CLAMPED>
+static void row_pass_kernel(const Image& src, Image& dst, const ResamplePlan& plan, int row0, int row1,
+                            std::pair<double, double>& p) {
+    using V = vec_t<T>;
+    const int LANES = Simd<T>::LANES, BATCH = row_batch<T>();
+    const int taps = TAPS ? TAPS : plan.taps;  // 取樣點數，編譯期已知時迴圈會被完全展開
+    T mn = p.first, mx = p.second;  // 記錄最大值、最小值
+    int i = row0;
+
+    // 每次處理 BATCH 列：每一列放在向量的一個 lane，所有列共用同一組權重
+    // 使用兩個向量累加，讓相鄰的加法沒有相依性
+    std::vector<V> strip(2 * src.width);  // 交錯排列的輸入，strip[2x + v][r] = src.data[i + v * LANES + r][x]
+    V vmx = {}, vmn = {};                 // 各 lane 的最大值、最小值
+    vmx += mx, vmn += mn;
+    for (; i + BATCH <= row1; i += BATCH) {
+        for (int x = 0; x < src.width; x++)
+            for (int r = 0; r < BATCH; r++)
+                strip[2 * x + r / LANES][r % LANES] = src.data[i + r][x];
 
         for (int j = 0; j < dst.width; j++) {
-            double xi = j * scale;  // 在原始影像中的位置
+            const V* ys = strip.data() + 2 * plan.start[j];  // 取樣點
+            const T* w = plan.weight<T>(j);                  // 對應的權重
+
+            V acc0 = {}, acc1 = {};
+            for (int t = 0; t < taps; t++) {
+                acc0 += w[t] * ys[2 * t];
+                acc1 += w[t] * ys[2 * t + 1];
+            }
 
-            auto [left, right] = get_sliding_range((int)xi, src.width, blockSize);  // 取樣區塊的範圍
+            if (CLAMPED) acc0 = vclamp(acc0), acc1 = vclamp(acc1);
+            vmx = vmax(vmx, vmax(acc0, acc1)), vmn = vmin(vmn, vmin(acc0, acc1));
 
-            if (left != last_left) {  // 更新取樣點 (如有需要)
-                for (int jj = 0, l = left; l < right; jj++, l++)
-                    ys[jj] = src.data[i][l];
-                last_left = left;
+            for (int r = 0; r < LANES; r++) {
+                dst.data[i + r][j] = acc0[r];
+                dst.data[i + LANES + r][j] = acc1[r];
             }
+        }
+    }
+
+    for (int r = 0; r < LANES; r++)
+        mx = std::max(mx, vmx[r]), mn = std::min(mn, vmn[r]);
 
-            double value = lagrange(ys, xi - left);
-            if (clamped) value = clamp(value);
+    // 剩下不足一個批次的列
+    for (; i < row1; i++) {
+        const float* in = src.data[i];
+        float* out = dst.data[i];
+
+        for (int j = 0; j < dst.width; j++) {
+            const float* ys = in + plan.start[j];  // 取樣點
+            const T* w = plan.weight<T>(j);        // 對應的權重
+
+            T value = 0;
+            for (int t = 0; t < taps; t++)
+                value += w[t] * ys[t];
+            if (CLAMPED) value = clamp(value);
             mx = std::max(mx, value), mn = std::min(mn, value);
 
-            dst.data[i][j] = value;
+            out[j] = value;
+        }
+    }
+
+    p = {mn, mx};
+}
+
+/**
+ * 行方向插值的核心：計算 dst 的第 [row0, row1) 列
+ * 直接讀取輸入影像的列並累加，不需要轉置影像；每一個輸出列是 taps 個輸入列的加權和
+ *
+ * @tparam T 計算使用的純量型別 (double 或 float)
+ * @tparam TAPS 取樣點數，0 表示執行時才決定 (使用 plan.taps)
+ * @tparam CLAMPED 是否將結果限制在 [0, 1]
+ * @param src 輸入影像，高度需為 plan.N
+ * @param dst 輸出影像，高度需為 plan.M，寬度與 src 相同
+ * @param plan 重取樣計畫
+ * @param row0 起始列
+ * @param row1 結束列 (不含)
+ * @param p 目前的最小值與最大值，會被更新
+ */
+template <typename T, int TAPS, bool CLAMPED>
+static void col_pass_kernel(const Image& src, Image& dst, const ResamplePlan& plan, int row0, int row1,
+                            std::pair<double, double>& p) {
+    using V = vec_t<T>;
+    typedef float VF __attribute__((vector_size(Simd<T>::LANES * sizeof(float))));  // 與 V 相同 lane 數的 float 向量
+    const int LANES = Simd<T>::LANES;
+    const int CHUNK = 512;                     // 每次處理的寬度，讓累加用的緩衝區留在 L1 快取中
+    const int taps = TAPS ? TAPS : plan.taps;  // 取樣點數，編譯期已知時迴圈會被完全展開
+    T mn = p.first, mx = p.second;  // 記錄最大值、最小值
+    std::vector<V> acc(CHUNK / LANES);
+    V vmx = {}, vmn = {};  // 各 lane 的最大值、最小值
+    vmx += mx, vmn += mn;
+
+    for (int i = row0; i < row1; i++) {
+        const float* const* ys = src.data + plan.start[i];  // 取樣的輸入列
+        const T* w = plan.weight<T>(i);                    // 對應的權重
+        float* out = dst.data[i];
+
+        for (int x0 = 0; x0 < dst.width; x0 += CHUNK) {
+            int n = std::min(CHUNK, dst.width - x0), nv = n / LANES;
+            std::fill(acc.begin(), acc.begin() + nv, V{});
+            for (int t = 0; t < taps; t++) {
+                const float* in = ys[t] + x0;
+                V wt = {};
+                wt += w[t];
+                for (int v = 0; v < nv; v++) {
+                    VF f;
+                    memcpy(&f, in + v * LANES, sizeof(f));  // 輸入列不一定對齊
+                    acc[v] += wt * __builtin_convertvector(f, V);
+                }
+            }
+
+            for (int v = 0; v < nv; v++) {
+                V value = acc[v];
+                if (CLAMPED) value = vclamp(value);
+                vmx = vmax(vmx, value), vmn = vmin(vmn, value);
+                VF f = __builtin_convertvector(value, VF);
+                memcpy(out + x0 + v * LANES, &f, sizeof(f));
+            }
+
+            // 剩下不足一個向量的像素
+            for (int x = nv * LANES; x < n; x++) {
+                T value = 0;
+                for (int t = 0; t < taps; t++)
+                    value += w[t] * ys[t][x0 + x];
+                if (CLAMPED) value = clamp(value);
+                mx = std::max(mx, value), mn = std::min(mn, value);
+                out[x0 + x] = value;
+            }
         }
     }
 
-    return {mn, mx};
+    for (int r = 0; r < LANES; r++)
+        mx = std::max(mx, vmx[r]), mn = std::min(mn, vmn[r]);
+    p = {mn, mx};
+}
+
+// 編譯期特化的取樣點數 (plan.taps)：K 為 1、2、4、8、16、32 且整除 N 時，sliding、block 為 K，overlap 為 K + 2；
+// sliding 另外涵蓋 K = 3、6、10、18、34。其他 K 值 (例如 K = 5 或 block 調整後的區塊大小) 使用執行期取樣點數的版本
+using SpecializedTaps = std::integer_sequence<int, 1, 2, 3, 4, 6, 8, 10, 16, 18, 32, 34>;
+
+/**
+ * 依照計畫的取樣點數選擇編譯期特化的核心，不在 SpecializedTaps 中時使用一般的版本
+ */
+template <typename T, bool CLAMPED, int... TAPS>
+static void row_pass(std::integer_sequence<int, TAPS...>, const Image& src, Image& dst, const ResamplePlan& plan,
+                     int row0, int row1, std::pair<double, double>& p) {
+    bool found = ((plan.taps == TAPS && (row_pass_kernel<T, TAPS, CLAMPED>(src, dst, plan, row0, row1, p), true)) || ...);
+    if (!found) row_pass_kernel<T, 0, CLAMPED>(src, dst, plan, row0, row1, p);
+}
+
+template <typename T, bool CLAMPED, int... TAPS>
+static void col_pass(std::integer_sequence<int, TAPS...>, const Image& src, Image& dst, const ResamplePlan& plan,
+                     int row0, int row1, std::pair<double, double>& p) {
+    bool found = ((plan.taps == TAPS && (col_pass_kernel<T, TAPS, CLAMPED>(src, dst, plan, row0, row1, p), true)) || ...);
+    if (!found) col_pass_kernel<T, 0, CLAMPED>(src, dst, plan, row0, row1, p);
+}
+
+template <typename T>
+static void row_pass(const Image& src, Image& dst, const ResamplePlan& plan, bool clamped, int row0, int row1,
+                     std::pair<double, double>& p) {
+    if (clamped)
+        row_pass<T, true>(SpecializedTaps(), src, dst, plan, row0, row1, p);
+    else
+        row_pass<T, false>(SpecializedTaps(), src, dst, plan, row0, row1, p);
+}
+
+template <typename T>
+static void col_pass(const Image& src, Image& dst, const ResamplePlan& plan, bool clamped, int row0, int row1,
+                     std::pair<double, double>& p) {
+    if (clamped)
+        col_pass<T, true>(SpecializedTaps(), src, dst, plan, row0, row1, p);
+    else
+        col_pass<T, false>(SpecializedTaps(), src, dst, plan, row0, row1, p);
+}
+
+/**
+ * 使用預先計算的重取樣計畫進行列方向的 super sampling
+ * 每個輸出像素只需要與計畫中的權重做一次內積
+ *
+ * @param src 輸入影像，寬度需為 plan.N
+ * @param dst 輸出影像，寬度需為 plan.M
+ * @param plan 重取樣計畫
+ * @param clamped 是否將結果限制在 [0, 1]
+ *
+ * @return std::pair<double, double> 計算出的最小值與最大值
+ */
+std::pair<double, double> resample_row(const Image& src, Image& dst, const ResamplePlan& plan, bool clamped) {
+    std::pair<double, double> p = {0.0, 1.0};  // 記錄最小值、最大值
+    if (plan.method & USE_FLOAT32)
+        row_pass<float>(src, dst, plan, clamped, 0, dst.height, p);
+    else
+        row_pass<double>(src, dst, plan, clamped, 0, dst.height, p);
+    return p;
+}
+
+/**
+ * 使用預先計算的重取樣計畫進行行方向的 super sampling
+ *
+ * @param src 輸入影像，高度需為 plan.N
+ * @param dst 輸出影像，高度需為 plan.M，寬度與 src 相同
+ * @param plan 重取樣計畫
+ * @param clamped 是否將結果限制在 [0, 1]
+ *
+ * @return std::pair<double, double> 計算出的最小值與最大值
+ */
+std::pair<double, double> resample_col(const Image& src, Image& dst, const ResamplePlan& plan, bool clamped) {
+    std::pair<double, double> p = {0.0, 1.0};  // 記錄最小值、最大值
+    if (plan.method & USE_FLOAT32)
+        col_pass<float>(src, dst, plan, clamped, 0, dst.height, p);
+    else
+        col_pass<double>(src, dst, plan, clamped, 0, dst.height, p);
+    return p;
+}
+
+// 計畫中第 [j0, j1) 個輸出位置移動取樣視窗的次數 (視窗起點與前一個位置不同，第一個位置也算一次)
+static uint64_t window_reloads(const ResamplePlan& plan, int j0, int j1) {
+    uint64_t n = 0;
+    for (int j = j0; j < j1; j++)
+        n += (j == j0 || plan.start[j] != plan.start[j - 1]);
+    return n;
+}
+
+/**
+ * 以串流方式計算 super sampling 的第 [row0, row1) 個輸出列
+ *
+ * 不建立完整的中間影像，而是使用只有 plan_y.taps + row_batch<T>() 列的環形緩衝區：
+ * 列方向插值的結果在需要時才計算，每個輸出列的取樣視窗一備齊就立即進行行方向插值。
+ * 由於視窗只會往下移動，每一個中間列只會計算一次。
+ *
+ * @tparam T 計算使用的純量型別 (double 或 float)
+ * @param src 輸入影像
+ * @param dst 輸出影像
+ * @param plan_x 列方向 (寬度) 的重取樣計畫
+ * @param plan_y 行方向 (高度) 的重取樣計畫
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP、CLAMP_AT_END 或 NORMALIZE_AT_END)
+ * @param row0 起始的輸出列
+ * @param row1 結束的輸出列 (不含)
+ * @param p1 列方向插值的最小值與最大值，會被更新
+ * @param p2 行方向插值的最小值與最大值，會被更新
+ */
+template <typename T>
+static void stream_rows(const Image& src, Image& dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y,
+                        int clamping, int row0, int row1, std::pair<double, double>& p1,
+                        std::pair<double, double>& p2) {
+    bool clamped = (clamping == CLAMP_EACH_STEP);  // 是否在每次插值時 clamp
+    int size = std::min(src.height, plan_y.taps + row_batch<T>());
+    Image ring = acquireImage(dst.width, size, false);  // 環形緩衝區，每一列在使用前都會先被計算
+
+    // 第 r 個中間列存放在環形緩衝區的第 r % size 列，讓核心函式可以用原本的列編號存取
+    std::vector<float*> rows(src.height);
+    for (int r = 0; r < src.height; r++)
+        rows[r] = ring.data[r % size];
+    Image mid = ring;
+    mid.data = rows.data();
+    mid.height = src.height;
+
+    int done = 0;           // [.., done) 的中間列已經計算完成
+    uint64_t computed = 0;  // 計算過的中間列數
+    for (int i = row0; i < row1; i++) {
+        int top = plan_y.start[i], bottom = top + plan_y.taps;  // 需要的中間列
+        if (done < top) done = top;                               // 跳過不需要的列
+        if (done < bottom) {                                      // 一次補齊一個批次
+            int end = std::min(src.height, std::max(bottom, done + row_batch<T>()));
+            ScopedTimer timer(STAGE_ROW_PASS);
+            row_pass<T>(src, mid, plan_x, clamped, done, end, p1);
+            computed += end - done, done = end;
+        }
+
+        {
+            ScopedTimer timer(STAGE_COL_PASS);
+            col_pass<T>(mid, dst, plan_y, clamped, i, i + 1, p2);
+        }
+        if (clamping == CLAMP_AT_END) {  // 這一列已經完成，可以直接 clamp
+            ScopedTimer timer(STAGE_CLAMP);
+            for (int j = 0; j < dst.width; j++)
+                dst.data[i][j] = clamp(dst.data[i][j]);
+        }
+    }
+
+    if (stats_enabled) {
+        stats_add(PIXELS_PRODUCED, (uint64_t)(row1 - row0) * dst.width);
+        stats_add(WINDOW_RELOADS, computed * window_reloads(plan_x, 0, plan_x.M) + window_reloads(plan_y, row0, row1));
+        stats_excursion(std::min(p1.first, p2.first), std::max(p1.second, p2.second));
+    }
+    releaseImage(ring);
+}
+
+/**
+ * 以串流方式計算 super sampling 的第 [row0, row1) 個輸出列
+ * 依照計畫是否帶有 USE_FLOAT32 選擇單精度或雙精度的計算
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像
+ * @param plan_x 列方向 (寬度) 的重取樣計畫
+ * @param plan_y 行方向 (高度) 的重取樣計畫
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP、CLAMP_AT_END 或 NORMALIZE_AT_END)
+ * @param row0 起始的輸出列
+ * @param row1 結束的輸出列 (不含)
+ * @param p1 列方向插值的最小值與最大值，會被更新
+ * @param p2 行方向插值的最小值與最大值，會被更新
+ */
+void super_sample_rows(const Image& src, Image& dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y,
+                       int clamping, int row0, int row1, std::pair<double, double>& p1,
+                       std::pair<double, double>& p2) {
+    if (plan_x.method & USE_FLOAT32)
+        stream_rows<float>(src, dst, plan_x, plan_y, clamping, row0, row1, p1, p2);
+    else
+        stream_rows<double>(src, dst, plan_x, plan_y, clamping, row0, row1, p1, p2);
 }
 
 /**
  * 進行 super sampling
- * 先對行方向進行插值，再對列方向進行插值
+ * 先對列方向進行插值，再對行方向進行插值
  *
  * @param src 輸入影像
  * @param dst 輸出影像
@@ -166,48 +503,331 @@ std::pair<double, double> sliding_row(const Image& src, Image& dst, int blockSiz
  * @param method 計算方法
  *      十六位數: 0: 使用區塊取樣 (預設)，1: 使用 overlap 取樣，2: 使用 sliding window
  *      個位數: 0: 每次插值時 clamp，1: 最後再 clamp (預設)，2: 線性正規化
+ *      百位數: 0: 一般 Lagrange 公式計算權重 (預設)，1: 使用重心公式 (USE_BARYCENTRIC)，
+ *              2: 使用單精度浮點數計算 (USE_FLOAT32)，可與 USE_BARYCENTRIC 同時使用
+ * @param threads 執行緒數量，0 表示使用所有核心
  */
-void super_sample(const Image& src, Image& dst, int blockSize, int method) {
-    Image mid = zerosImage(dst.width, src.height, NULL);  // 中間影像
-
-    bool overlap = (method / 16 == 1);  // 是否使用 overlap 取樣
-    bool clamped = (method % 16 == 0);  // 是否在每次插值時 clamp
-    std::pair<double, double> p1, p2;   // 記錄最大值、最小值
-
-    if (method / 16 < 2) {  // 使用一般或 overlap 方法
-        // 列方向插值
-        p1 = super_row(src, mid, blockSize, overlap, clamped);
-        transposeImage(&mid);
-        // 行方向插值
-        p2 = super_row(mid, dst, blockSize, overlap, clamped);
-        transposeImage(&dst);
-    } else if (method / 16 == 2) {  // 使用 sliding window 方法
-        // 列方向插值
-        p1 = sliding_row(src, mid, blockSize, clamped);
-        // 行方向插值
-        transposeImage(&mid);
-        p2 = sliding_row(mid, dst, blockSize, clamped);
-        transposeImage(&dst);
-    } else {  // 未知的方法
+void super_sample(const Image& src, Image& dst, int blockSize, int method, int threads) {
+    if ((method & 0xF0) > USE_METHOD_SLIDING) {  // 未知的方法
         std::cerr << "Error: Unknown method code " << std::hex << method << std::endl;
-        freeImage(mid);
         return;
     }
 
-    double mn1 = p1.first, mx1 = p1.second, mn2 = p2.first, mx2 = p2.second;
+    ResamplePlan plan_x = get_plan(src.width, dst.width, blockSize, method);  // 列方向的計畫
+    if (src.width == src.height && dst.width == dst.height) {                 // 正方形影像兩個方向可以共用
+        super_sample(src, dst, plan_x, plan_x, method & 0x0F, threads);
+    } else {
+        ResamplePlan plan_y = get_plan(src.height, dst.height, blockSize, method);  // 行方向的計畫
+        super_sample(src, dst, plan_x, plan_y, method & 0x0F, threads);
+    }
+}
 
-    if (method % 16 == CLAMP_AT_END) {  // 最後再 clamp
-        for (int i = 0; i < dst.height; i++)
-            for (int j = 0; j < dst.width; j++)
-                dst.data[i][j] = clamp(dst.data[i][j]);
-    } else if (method % 16 == NORMALIZE_AT_END) {  // 正規化到 [0, 1]
-        double mx = std::max(mx1, mx2), mn = std::min(mn1, mn2);
-        for (int i = 0; i < dst.height; i++) {
-            for (int j = 0; j < dst.width; j++) {
-                dst.data[i][j] = normalize(dst.data[i][j], mn, mx);
-            }
+/**
+ * 使用預先計算的重取樣計畫進行 super sampling
+ * 同一組計畫可以重複用在相同尺寸的多張影像上
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像
+ * @param plan_x 列方向 (寬度) 的重取樣計畫
+ * @param plan_y 行方向 (高度) 的重取樣計畫
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP、CLAMP_AT_END 或 NORMALIZE_AT_END)
+ * @param threads 執行緒數量，0 表示使用所有核心
+ */
+void super_sample(const Image& src, Image& dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y, int clamping,
+                  int threads) {
+    // 將輸出切成數個列區段，每個執行緒各自以串流方式計算，最後再合併最小值、最大值
+    // 最小值、最大值與合併順序無關，因此結果與單執行緒完全相同
+    if (threads <= 0) threads = default_threads();
+    threads = std::max(1, std::min(threads, dst.height / row_batch<float>()));
+    std::vector<std::pair<double, double>> p1(threads, {0.0, 1.0}), p2(threads, {0.0, 1.0});
+
+    parallel_for(0, threads, 1, threads, [&](int lo, int hi) {
+        for (int t = lo; t < hi; t++) {
+            int row0 = (long long)dst.height * t / threads, row1 = (long long)dst.height * (t + 1) / threads;
+            super_sample_rows(src, dst, plan_x, plan_y, clamping, row0, row1, p1[t], p2[t]);
         }
+    });
+
+    super_sample_finish(dst, clamping, p1, p2, threads);
+}
+
+/**
+ * 完成 super sampling 的最後步驟
+ * 合併各列區段的最小值、最大值，需要時將整張影像正規化到 [0, 1]
+ *
+ * @param dst 輸出影像
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP、CLAMP_AT_END 或 NORMALIZE_AT_END)
+ * @param p1 各區段列方向插值的最小值與最大值
+ * @param p2 各區段行方向插值的最小值與最大值
+ * @param threads 執行緒數量，0 表示使用所有核心
+ */
+void super_sample_finish(Image& dst, int clamping, const std::vector<std::pair<double, double>>& p1,
+                         const std::vector<std::pair<double, double>>& p2, int threads) {
+    double mx = 1.0, mn = 0.0;  // 記錄最大值、最小值
+    for (auto [lo, hi] : p1)
+        mx = std::max(mx, hi), mn = std::min(mn, lo);
+    for (auto [lo, hi] : p2)
+        mx = std::max(mx, hi), mn = std::min(mn, lo);
+
+    if (clamping == NORMALIZE_AT_END) {  // 正規化到 [0, 1]
+        ScopedTimer timer(STAGE_CLAMP);
+        parallel_for(0, dst.height, 1, threads, [&](int lo, int hi) {
+            for (int i = lo; i < hi; i++) {
+                for (int j = 0; j < dst.width; j++) {
+                    dst.data[i][j] = normalize(dst.data[i][j], mn, mx);
+                }
+            }
+        });
     }
+}
+
+/**********************************************************************************************************************/
 
-    freeImage(mid);
+/**
+ * 列方向的 super sampling (影像視窗)
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像，高度需與 src 相同
+ * @param blockSize 區塊大小 (K)
+ * @param overlap 是否使用重疊取樣
+ * @param clamped 是否將結果限制在 [0, 1]
+ *
+ * @return std::pair<double, double> 計算出的最小值與最大值
+ */
+std::pair<double, double> super_row(ConstImageView src, ImageView dst, int blockSize, bool overlap, bool clamped) {
+    std::vector<float*> src_rows, dst_rows;
+    Image in = view_as_image(src, src_rows), out = view_as_image(dst, dst_rows);
+    return super_row(in, out, blockSize, overlap, clamped);
+}
+
+/**
+ * 列方向的 super sampling，使用 sliding window (影像視窗)
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像，高度需與 src 相同
+ * @param blockSize 區塊大小 (K)
+ * @param clamped 是否將結果限制在 [0, 1]
+ *
+ * @return std::pair<double, double> 計算出的最小值與最大值
+ */
+std::pair<double, double> sliding_row(ConstImageView src, ImageView dst, int blockSize, bool clamped) {
+    std::vector<float*> src_rows, dst_rows;
+    Image in = view_as_image(src, src_rows), out = view_as_image(dst, dst_rows);
+    return sliding_row(in, out, blockSize, clamped);
+}
+
+/**
+ * 進行 super sampling (影像視窗)
+ * 輸出直接寫入 dst 指向的像素，例如另一張影像的一個矩形
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像
+ * @param blockSize 區塊大小 (K)
+ * @param method 計算方法，與 super_sample(const Image&, Image&, int, int, int) 相同
+ * @param threads 執行緒數量，0 表示使用所有核心
+ */
+void super_sample(ConstImageView src, ImageView dst, int blockSize, int method, int threads) {
+    std::vector<float*> src_rows, dst_rows;
+    Image in = view_as_image(src, src_rows), out = view_as_image(dst, dst_rows);
+    super_sample(in, out, blockSize, method, threads);
+}
+
+/**
+ * 使用預先計算的重取樣計畫進行 super sampling (影像視窗)
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像
+ * @param plan_x 列方向 (寬度) 的重取樣計畫
+ * @param plan_y 行方向 (高度) 的重取樣計畫
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP、CLAMP_AT_END 或 NORMALIZE_AT_END)
+ * @param threads 執行緒數量，0 表示使用所有核心
+ */
+void super_sample(ConstImageView src, ImageView dst, const ResamplePlan& plan_x, const ResamplePlan& plan_y,
+                  int clamping, int threads) {
+    std::vector<float*> src_rows, dst_rows;
+    Image in = view_as_image(src, src_rows), out = view_as_image(dst, dst_rows);
+    super_sample(in, out, plan_x, plan_y, clamping, threads);
+}
+
+/**
+ * 區域 super sampling：只計算完整輸出中以 (x0, y0) 為左上角、大小與 dst 相同的矩形
+ *
+ * 以子計畫只計算矩形需要的輸出位置：行方向只用到矩形各列的取樣視窗涵蓋的中間列，
+ * 列方向只計算矩形的行，並且只讀取這些行的取樣視窗涵蓋的輸入行，因此計算量與矩形面積成正比，與 M² 無關。
+ * 每個像素的計算與完整計算完全相同，結果也完全相同。
+ *
+ * @param src 完整的輸入影像
+ * @param dst 輸出的矩形
+ * @param x0 矩形在完整輸出中的左界
+ * @param y0 矩形在完整輸出中的上界
+ * @param plan_x 完整輸出的列方向 (寬度) 重取樣計畫
+ * @param plan_y 完整輸出的行方向 (高度) 重取樣計畫
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP 或 CLAMP_AT_END)
+ * @param threads 執行緒數量，0 表示使用所有核心
+ *
+ * @return 矩形超出範圍或使用 NORMALIZE_AT_END 時回傳 false
+ */
+bool super_sample_region(ConstImageView src, ImageView dst, int x0, int y0, const ResamplePlan& plan_x,
+                         const ResamplePlan& plan_y, int clamping, int threads) {
+    if (clamping == NORMALIZE_AT_END) {
+        std::cerr << "Error: NORMALIZE_AT_END needs the whole image and cannot be used on a region" << std::endl;
+        return false;
+    }
+    if (src.width != plan_x.N || src.height != plan_y.N || x0 < 0 || y0 < 0 || x0 + dst.width > plan_x.M ||
+        y0 + dst.height > plan_y.M) {
+        std::cerr << "Error: Region out of range" << std::endl;
+        return false;
+    }
+    if (dst.empty()) return true;
+
+    int left, top;  // 子計畫的輸入在完整輸入中的起點
+    ResamplePlan sub_x = plan_x.slice(x0, dst.width, left), sub_y = plan_y.slice(y0, dst.height, top);
+    super_sample(src.sub(left, top, sub_x.N, sub_y.N), dst, sub_x, sub_y, clamping, threads);
+    return true;
+}
+
+/**
+ * 區域 super sampling
+ *
+ * @param src 完整的輸入影像
+ * @param dst 輸出的矩形
+ * @param dstWidth 完整輸出的寬度
+ * @param dstHeight 完整輸出的高度
+ * @param x0 矩形在完整輸出中的左界
+ * @param y0 矩形在完整輸出中的上界
+ * @param blockSize 區塊大小 (K)
+ * @param method 計算方法，與 super_sample 相同 (不支援 NORMALIZE_AT_END)
+ * @param threads 執行緒數量，0 表示使用所有核心
+ *
+ * @return 矩形超出範圍或使用 NORMALIZE_AT_END 時回傳 false
+ */
+bool super_sample_region(ConstImageView src, ImageView dst, int dstWidth, int dstHeight, int x0, int y0,
+                         int blockSize, int method, int threads) {
+    if ((method & 0xF0) > USE_METHOD_SLIDING) {  // 未知的方法
+        std::cerr << "Error: Unknown method code " << std::hex << method << std::endl;
+        return false;
+    }
+
+    ResamplePlan plan_x = get_plan(src.width, dstWidth, blockSize, method);  // 列方向的計畫
+    if (src.width == src.height && dstWidth == dstHeight)                    // 正方形影像兩個方向可以共用
+        return super_sample_region(src, dst, x0, y0, plan_x, plan_x, method & 0x0F, threads);
+    ResamplePlan plan_y = get_plan(src.height, dstHeight, blockSize, method);  // 行方向的計畫
+    return super_sample_region(src, dst, x0, y0, plan_x, plan_y, method & 0x0F, threads);
+}
+
+/**********************************************************************************************************************/
+
+/**
+ * 取樣視窗與輸入範圍 [lo, hi) 相交的輸出位置
+ * 計畫的視窗起點隨輸出位置遞增，因此這些位置是連續的一段
+ *
+ * @return 輸出位置的範圍 [first, last)
+ */
+static std::pair<int, int> affected_range(const ResamplePlan& plan, int lo, int hi) {
+    int first = 0;
+    while (first < plan.M && plan.start[first] + plan.taps <= lo)
+        first++;
+    int last = first;
+    while (last < plan.M && plan.start[last] < hi)
+        last++;
+    return {first, last};
+}
+
+/**
+ * 增量 super sampling：輸入只在 dirty 矩形內改變時，只重新計算受影響的輸出像素
+ *
+ * 輸出像素 (i, j) 只與列方向視窗 plan_x.start[j] ~ + taps 及行方向視窗 plan_y.start[i] ~ + taps 內的輸入有關，
+ * 因此需要重新計算的是視窗與 dirty 相交的輸出行與輸出列所構成的矩形。
+ * overlap、sliding 的視窗較寬，影響的範圍也較大，這些都已經反映在計畫的視窗中。
+ * 矩形以 super_sample_region 重新計算，結果與完整重新計算完全相同。
+ *
+ * @param src 新的輸入影像
+ * @param dst 舊的輸入以相同參數計算的輸出影像，會被更新
+ * @param dirty 輸入中改變的矩形
+ * @param plan_x 列方向 (寬度) 的重取樣計畫
+ * @param plan_y 行方向 (高度) 的重取樣計畫
+ * @param clamping clamp 時機 (CLAMP_EACH_STEP、CLAMP_AT_END 或 NORMALIZE_AT_END)
+ * @param threads 執行緒數量，0 表示使用所有核心
+ * @param updated 傳回重新計算的輸出矩形，可以為 NULL
+ *
+ * @return 影像大小與計畫不符時回傳 false
+ */
+bool super_sample_update(ConstImageView src, ImageView dst, ImageRect dirty, const ResamplePlan& plan_x,
+                         const ResamplePlan& plan_y, int clamping, int threads, ImageRect* updated) {
+    if (updated) *updated = {};
+    if (src.width != plan_x.N || src.height != plan_y.N || dst.width != plan_x.M || dst.height != plan_y.M) {
+        std::cerr << "Error: Image size does not match the resample plan" << std::endl;
+        return false;
+    }
+
+    // 限制在輸入的範圍內
+    int x0 = std::max(0, dirty.x), x1 = std::min(src.width, dirty.x + dirty.width);
+    int y0 = std::max(0, dirty.y), y1 = std::min(src.height, dirty.y + dirty.height);
+    if (x0 >= x1 || y0 >= y1) return true;
+
+    if (clamping == NORMALIZE_AT_END) {  // 最小值、最大值可能改變，每個像素都可能不同
+        super_sample(src, dst, plan_x, plan_y, clamping, threads);
+        if (updated) *updated = {0, 0, dst.width, dst.height};
+        return true;
+    }
+
+    auto [j0, j1] = affected_range(plan_x, x0, x1);
+    auto [i0, i1] = affected_range(plan_y, y0, y1);
+    ImageRect rect = {j0, i0, j1 - j0, i1 - i0};
+    if (rect.empty()) return true;
+    if (!super_sample_region(src, dst.sub(j0, i0, rect.width, rect.height), j0, i0, plan_x, plan_y, clamping, threads))
+        return false;
+    if (updated) *updated = rect;
+    return true;
+}
+
+/**
+ * 增量 super sampling
+ *
+ * @param src 新的輸入影像
+ * @param dst 舊的輸入以相同參數計算的輸出影像，會被更新
+ * @param dirty 輸入中改變的矩形
+ * @param blockSize 區塊大小 (K)
+ * @param method 計算方法，與 super_sample 相同
+ * @param threads 執行緒數量，0 表示使用所有核心
+ * @param updated 傳回重新計算的輸出矩形，可以為 NULL
+ *
+ * @return 方法錯誤或影像大小不符時回傳 false
+ */
+bool super_sample_update(ConstImageView src, ImageView dst, ImageRect dirty, int blockSize, int method, int threads,
+                         ImageRect* updated) {
+    if ((method & 0xF0) > USE_METHOD_SLIDING) {  // 未知的方法
+        std::cerr << "Error: Unknown method code " << std::hex << method << std::endl;
+        return false;
+    }
+
+    ResamplePlan plan_x = get_plan(src.width, dst.width, blockSize, method);  // 列方向的計畫
+    if (src.width == src.height && dst.width == dst.height)                   // 正方形影像兩個方向可以共用
+        return super_sample_update(src, dst, dirty, plan_x, plan_x, method & 0x0F, threads, updated);
+    ResamplePlan plan_y = get_plan(src.height, dst.height, blockSize, method);  // 行方向的計畫
+    return super_sample_update(src, dst, dirty, plan_x, plan_y, method & 0x0F, threads, updated);
+}
+
+/**
+ * 增量 super sampling，比較舊的與新的輸入找出改變的矩形
+ * 適合連續的影格 (相鄰影格只有一小部分不同)
+ *
+ * @param prev 舊的輸入影像
+ * @param src 新的輸入影像，大小需與 prev 相同
+ * @param dst prev 以相同參數計算的輸出影像，會被更新
+ * @param blockSize 區塊大小 (K)
+ * @param method 計算方法，與 super_sample 相同
+ * @param threads 執行緒數量，0 表示使用所有核心
+ * @param updated 傳回重新計算的輸出矩形，可以為 NULL
+ *
+ * @return 方法錯誤或影像大小不符時回傳 false
+ */
+bool super_sample_update(ConstImageView prev, ConstImageView src, ImageView dst, int blockSize, int method,
+                         int threads, ImageRect* updated) {
+    if (prev.width != src.width || prev.height != src.height) {
+        std::cerr << "Error: Image size mismatch" << std::endl;
+        if (updated) *updated = {};
+        return false;
+    }
+    return super_sample_update(src, dst, image_diff_rect(prev, src), blockSize, method, threads, updated);
 }
@@ -0,0 +1,149 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "image.h"
+#include "parallel.h"
+#include "simd.h"
+
+#define METRICS_GRAIN 16  // 每個執行緒至少處理的列數
+#define SSIM_BLOCK 512    // SSIM 一次處理的行數，讓環形緩衝區留在快取中
+
+double image_mse(const Image& a, const Image& b, int threads) {
+    // 每一列的誤差分別加總，最後依序相加，結果與切割方式無關
+    std::vector<double> rows(a.height);
+    parallel_for(0, a.height, METRICS_GRAIN, threads, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            double sum = 0;
+            for (int j = 0; j < a.width; j++) {
+                double d = (double)a.data[i][j] - b.data[i][j];
+                sum += d * d;
+            }
+            rows[i] = sum;
+        }
+    });
+
+    double sum = 0;
+    for (double r : rows)
+        sum += r;
+    return sum / ((double)a.width * a.height);
+}
+
+/**
+ * 水平方向的卷積：計算一列的 x、y、x²、y²、xy 的加權和
+ * 視窗權重左右對稱，先將對稱位置的值相加再乘上權重，乘法次數減半
+ *
+ * @param x 第一張影像的列
+ * @param y 第二張影像的列
+ * @param g 視窗權重 (2r + 1 個)
+ * @param tmp 暫存空間，5 個長度為 n + 2r 的陣列
+ * @param out 輸出，5 個長度為 n 的陣列
+ * @param n 輸出長度
+ */
+static void ssim_row_sums(const float* x, const float* y, const std::vector<double>& g, double* tmp, double* out,
+                          int n) {
+    int r = g.size() / 2, width = n + 2 * r;
+    for (int j = 0; j < width; j++) {
+        double u = x[j], v = y[j];
+        tmp[j] = u, tmp[width + j] = v;
+        tmp[2 * width + j] = u * u, tmp[3 * width + j] = v * v, tmp[4 * width + j] = u * v;
+    }
+    for (int c = 0; c < 5; c++) {  // 內層迴圈連續存取，由編譯器向量化
+        const double* q = tmp + c * width;
+        double* s = out + c * n;
+        for (int j = 0; j < n; j++)
+            s[j] = g[r] * q[j + r];
+        for (int k = 0; k < r; k++) {
+            double w = g[k];
+            const double *lo = q + k, *hi = q + 2 * r - k;
+            for (int j = 0; j < n; j++)
+                s[j] += w * (lo[j] + hi[j]);
+        }
+    }
+}
+
+// 由視窗內的加權平均計算一個位置的 SSIM (純量與向量版本共用)
+template <typename V>
+static inline V ssim_value(V mx, V my, V mxx, V myy, V mxy) {
+    const double C1 = SSIM_K1 * SSIM_K1, C2 = SSIM_K2 * SSIM_K2;
+    V vx = mxx - mx * mx, vy = myy - my * my, cov = mxy - mx * my;
+    return ((2 * mx * my + C1) * (2 * cov + C2)) / ((mx * mx + my * my + C1) * (vx + vy + C2));
+}
+
+double image_ssim(const Image& a, const Image& b, int threads) {
+    // 影像比視窗小時縮小視窗
+    int r = std::max(0, std::min(SSIM_RADIUS, (std::min(a.width, a.height) - 1) / 2));
+    int win = 2 * r + 1, ow = a.width - 2 * r, oh = a.height - 2 * r;
+    std::vector<double> g(win);
+    double total = 0;
+    for (int k = 0; k < win; k++)
+        total += g[k] = std::exp(-(double)(k - r) * (k - r) / (2 * SSIM_SIGMA * SSIM_SIGMA));
+    for (double& w : g)
+        w /= total;
+
+    using V = vec_t<double>;
+    const int LANES = Simd<double>::LANES;
+
+    // 每個執行緒負責一段輸出列，再切成數個行區塊，以環形緩衝區保存區塊內最近 win 列的水平加權和
+    std::vector<double> rows(oh, 0.0);
+    parallel_for(0, oh, METRICS_GRAIN, threads, [&](int lo, int hi) {
+        int bw = std::min(ow, SSIM_BLOCK);
+        std::vector<double> ring((size_t)win * 5 * bw), sums(5 * bw), tmp(5 * (bw + 2 * r));
+        for (int x0 = 0; x0 < ow; x0 += bw) {
+            int n = std::min(bw, ow - x0);
+            auto slot = [&](int i) { return ring.data() + (size_t)(i % win) * 5 * n; };
+            for (int i = lo; i < lo + win - 1; i++)
+                ssim_row_sums(a.data[i] + x0, b.data[i] + x0, g, tmp.data(), slot(i), n);
+
+            for (int o = lo; o < hi; o++) {
+                int i = o + win - 1;
+                ssim_row_sums(a.data[i] + x0, b.data[i] + x0, g, tmp.data(), slot(i), n);
+
+                // 垂直方向的卷積，同樣利用權重的對稱性
+                const double* mid = slot(o + r);
+                for (int j = 0; j < 5 * n; j++)
+                    sums[j] = g[r] * mid[j];
+                for (int k = 0; k < r; k++) {
+                    const double *top = slot(o + k), *bottom = slot(o + 2 * r - k);
+                    double w = g[k];
+                    for (int j = 0; j < 5 * n; j++)
+                        sums[j] += w * (top[j] + bottom[j]);
+                }
+
+                // 每個位置的 SSIM，一次計算 LANES 個位置
+                const double *mx = sums.data(), *my = mx + n, *mxx = my + n, *myy = mxx + n, *mxy = myy + n;
+                V acc = {};
+                int j = 0;
+                for (; j + LANES <= n; j += LANES) {
+                    V x, y, xx, yy, xy;
+                    memcpy(&x, mx + j, sizeof(V)), memcpy(&y, my + j, sizeof(V));
+                    memcpy(&xx, mxx + j, sizeof(V)), memcpy(&yy, myy + j, sizeof(V)), memcpy(&xy, mxy + j, sizeof(V));
+                    acc += ssim_value(x, y, xx, yy, xy);
+                }
+                double sum = 0;
+                for (int l = 0; l < LANES; l++)
+                    sum += acc[l];
+                for (; j < n; j++)
+                    sum += ssim_value(mx[j], my[j], mxx[j], myy[j], mxy[j]);
+                rows[o] += sum;  // 每一列依序加上各區塊的結果
+            }
+        }
+    });
+
+    double sum = 0;
+    for (double s : rows)
+        sum += s;
+    return sum / ((double)ow * oh);
+}
+
+bool compare_images(const Image& a, const Image& b, ImageMetrics& result, int threads) {
+    if (!a.data || !b.data || a.width != b.width || a.height != b.height || a.width <= 0 || a.height <= 0)
+        return false;
+    result.mse = image_mse(a, b, threads);
+    result.psnr = 10 * std::log10(1.0 / result.mse);
+    result.ssim = image_ssim(a, b, threads);
+    return true;
+}
@@ -0,0 +1,149 @@
+#include "plan.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "interpolation.h"
+
+/**
+ * 計算 Lagrange 基底多項式在 xi 的值
+ *
+ * @param n 取樣點數 (取樣點為 0, 1, ..., n - 1)
+ * @param xi 要插值的點
+ * @param w 輸出的 n 個權重
+ */
+static void lagrange_weights(int n, double xi, double* w) {
+    for (int i = 0; i < n; i++) {
+        double term = 1.0;
+        for (int j = 0; j < n; j++) {
+            if (i == j) continue;
+            term *= (xi - j) / (i - j);
+        }
+        w[i] = term;
+    }
+}
+
+/**
+ * 以重心公式計算 Lagrange 基底多項式在 xi 的值，只需要 O(n)
+ *
+ * @param bw n 個取樣點的重心權重 (barycentric_weights(n))，取樣點數 n 為 bw.size()
+ * @param xi 要插值的點
+ * @param w 輸出的 n 個權重
+ */
+static void barycentric_basis(const std::vector<double>& bw, double xi, double* w) {
+    int n = bw.size();
+    double den = 0.0;  // 分母
+    for (int i = 0; i < n; i++) {
+        if (xi == i) {  // 剛好落在取樣點上
+            std::fill(w, w + n, 0.0);
+            w[i] = 1.0;
+            return;
+        }
+        w[i] = bw[i] / (xi - i);
+        den += w[i];
+    }
+    double inv = 1.0 / den;
+    for (int i = 0; i < n; i++)
+        w[i] *= inv;
+}
+
+/**
+ * 建立重取樣計畫
+ *
+ * @param srcSize 輸入長度 (N)
+ * @param dstSize 輸出長度 (M)
+ * @param blockSize 區塊大小 (K)
+ * @param methodCode 取樣方法，只看十六位數 (USE_METHOD_*) 與百位數 (USE_BARYCENTRIC、USE_FLOAT32)
+ */
+ResamplePlan::ResamplePlan(int srcSize, int dstSize, int blockSize, int methodCode)
+    : N(srcSize), M(dstSize), K(blockSize), method(methodCode & 0x3F0) {
+    bool sliding = ((method & 0xF0) == USE_METHOD_SLIDING);
+    bool overlap = ((method & 0xF0) == USE_METHOD_OVERLAP);
+    if (!sliding) blockSize = N / (N / blockSize);  // 調整 blockSize 的大小，使每個區塊儘量均勻
+
+    double scale = (double)N / M;  // [0, M) -> [0, N) 的縮放比例
+
+    // 先求出每個位置的取樣範圍
+    std::vector<std::pair<int, int>> ranges(M);
+    int last_left = -1, last_right = -1;  // 上一次的取樣範圍
+    for (int j = 0; j < M; j++) {
+        double xi = j * scale;  // 在原始影像中的位置
+        auto [left, right] = sliding ? get_sliding_range((int)xi, N, blockSize)
+                                     : get_block_range((int)xi, N, blockSize);
+        if (overlap) {               // 使用 overlap 方式
+            if (left > 0) left--;    // 向左擴展取樣範圍
+            if (right < N) right++;  // 向右擴展取樣範圍
+        }
+        // 與逐點計算時相同：left 沒變就沿用上一次的取樣點 (overlap 且 K = 1 時左邊界會發生)
+        if (left == last_left) right = last_right;
+        last_left = left, last_right = right;
+        ranges[j] = {left, right};
+        taps = std::max(taps, right - left);
+    }
+
+    // 再把每個視窗放進長度為 taps 的窗格，多出來的位置權重為 0
+    // 因為 N / M 是有理數，插值點相對於視窗的位置只有有限種 (相位)，相同相位共用一組權重
+    std::map<std::tuple<int, int, long long>, int> phase_of;  // (視窗長度, 視窗偏移, 相對位置 * M) -> 相位編號
+    std::map<int, std::vector<double>> bary;                  // 視窗長度 -> 重心權重，每種長度只計算一次
+    start.resize(M);
+    phase.resize(M);
+    for (int j = 0; j < M; j++) {
+        auto [left, right] = ranges[j];
+        start[j] = std::min(left, N - taps);
+
+        long long pos = (long long)j * N - (long long)left * M;  // 插值點相對於 left 的位置，乘上 M 後為整數
+        auto key = std::make_tuple(right - left, left - start[j], pos);
+        auto it = phase_of.find(key);
+        if (it != phase_of.end()) {  // 已經計算過的相位
+            phase[j] = it->second;
+            continue;
+        }
+
+        phase[j] = phase_of[key] = weights.size() / taps;
+        weights.resize(weights.size() + taps, 0.0);
+        double* w = weights.data() + (size_t)phase[j] * taps + (left - start[j]);
+        if (method & USE_BARYCENTRIC) {
+            std::vector<double>& bw = bary[right - left];
+            if (bw.empty()) bw = barycentric_weights(right - left);
+            barycentric_basis(bw, (double)pos / M, w);
+        } else
+            lagrange_weights(right - left, (double)pos / M, w);
+    }
+
+    update_float_weights();
+}
+
+void ResamplePlan::update_float_weights() {
+    if (method & USE_FLOAT32)
+        weights_f.assign(weights.begin(), weights.end());
+    else
+        weights_f.clear(), weights_f.shrink_to_fit();
+}
+
+/**
+ * 取出第 [j0, j0 + count) 個輸出位置的子計畫
+ * 子計畫的輸入是原本輸入的 [first, first + N)，因此只需要傳入這一段輸入即可得到與原本計畫相同的結果
+ *
+ * @param j0 起始的輸出位置
+ * @param count 輸出位置的數量
+ * @param first 傳回子計畫的輸入在原本輸入中的起點
+ * @return 子計畫
+ */
+ResamplePlan ResamplePlan::slice(int j0, int count, int& first) const {
+    ResamplePlan sub;
+    sub.K = K, sub.method = method, sub.taps = taps, sub.M = count;
+    first = 0;
+    if (count <= 0) return sub;
+
+    first = *std::min_element(start.begin() + j0, start.begin() + j0 + count);
+    sub.N = *std::max_element(start.begin() + j0, start.begin() + j0 + count) + taps - first;
+    sub.start.assign(start.begin() + j0, start.begin() + j0 + count);
+    for (int& s : sub.start)
+        s -= first;
+    sub.phase.assign(phase.begin() + j0, phase.begin() + j0 + count);
+    sub.weights = weights, sub.weights_f = weights_f;
+    return sub;
+}
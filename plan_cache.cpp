@@ -0,0 +1,200 @@
+#include "plan_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "interpolation.h"
+#include "plan.h"
+
+#if !(_WIN32 || _WIN64)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+static const char PLAN_MAGIC[8] = {'S', 'S', 'P', 'L', 'A', 'N', '\0', '\0'};
+static const uint32_t PLAN_VERSION = 1;
+
+// 快取檔案的標頭，之後依序為權重、第一個週期的 (起點, 相位)、例外位置的 (位置, 起點, 相位)
+struct PlanFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t scalar;  // 檔案中權重的純量大小 (bytes)，單精度的計畫也以 double 儲存
+    int32_t N, M, K, method;
+    int32_t taps, phases;
+    int32_t period, shift;  // 每 period 個輸出位置，視窗起點前進 shift
+    int32_t head, exceptions;
+    uint64_t checksum;  // 除了 checksum 本身以外所有內容的 FNV-1a
+};
+static_assert(sizeof(PlanFileHeader) == 64, "PlanFileHeader must be 64 bytes");
+
+/**
+ * 計算 FNV-1a 雜湊值
+ *
+ * @param data 資料
+ * @param size 資料大小
+ * @param hash 初始值，可用於串接多段資料
+ * @return 雜湊值
+ */
+static uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// 計算整個檔案的 checksum，標頭中的 checksum 欄位不列入計算
+static uint64_t plan_checksum(const char* file, size_t size) {
+    uint64_t hash = fnv1a(file, offsetof(PlanFileHeader, checksum));
+    return fnv1a(file + sizeof(PlanFileHeader), size - sizeof(PlanFileHeader), hash);
+}
+
+std::string plan_cache_name(int N, int M, int K, int method) {
+    char name[96];
+    snprintf(name, sizeof(name), "plan_N%d_M%d_K%d_m%x_f%d.bin", N, M, K, method & 0x3F0,
+             (method & USE_FLOAT32) ? 32 : 64);
+    return name;
+}
+
+bool read_plan_cache(const char* filename, ResamplePlan& plan, int N, int M, int K, int method) {
+#if _WIN32 || _WIN64
+    (void)filename, (void)plan, (void)N, (void)M, (void)K, (void)method;
+    return false;  // Windows 不支援 mmap
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PlanFileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const char* file = (const char*)map;
+    const PlanFileHeader* h = (const PlanFileHeader*)file;
+    bool ok = memcmp(h->magic, PLAN_MAGIC, sizeof(PLAN_MAGIC)) == 0 && h->version == PLAN_VERSION &&
+              h->scalar == sizeof(double) && h->N == N && h->M == M && h->K == K && h->method == (method & 0x3F0) &&
+              h->taps > 0 && h->taps <= N && h->phases > 0 && h->period > 0 && h->head >= 0 && h->head <= M &&
+              h->exceptions >= 0 && h->exceptions <= M;
+
+    size_t nweights = ok ? (size_t)h->phases * h->taps : 0;
+    ok = ok && size == sizeof(PlanFileHeader) + nweights * sizeof(double) +
+                           ((size_t)h->head * 2 + (size_t)h->exceptions * 3) * sizeof(int32_t);
+    ok = ok && plan_checksum(file, size) == h->checksum;
+
+    if (ok) {
+        const double* weights = (const double*)(file + sizeof(PlanFileHeader));
+        const int32_t* head = (const int32_t*)(weights + nweights);
+        const int32_t* exc = head + (size_t)h->head * 2;
+
+        plan.N = N, plan.M = M, plan.K = K, plan.method = h->method;
+        plan.taps = h->taps;
+        plan.weights.assign(weights, weights + nweights);
+        plan.update_float_weights();
+        plan.start.resize(M);
+        plan.phase.resize(M);
+
+        // 依序還原每個位置：先看是否為例外，再看是否在第一個週期內，否則由前一個週期推得
+        int e = 0;
+        for (int j = 0; j < M && ok; j++) {
+            if (e < h->exceptions && exc[e * 3] == j) {
+                plan.start[j] = exc[e * 3 + 1], plan.phase[j] = exc[e * 3 + 2];
+                e++;
+            } else if (j < h->head) {
+                plan.start[j] = head[j * 2], plan.phase[j] = head[j * 2 + 1];
+            } else if (j >= h->period) {
+                plan.start[j] = plan.start[j - h->period] + h->shift, plan.phase[j] = plan.phase[j - h->period];
+            } else {
+                ok = false;
+            }
+            ok = ok && plan.start[j] >= 0 && plan.start[j] <= N - plan.taps && plan.phase[j] >= 0 &&
+                 plan.phase[j] < h->phases;
+        }
+        ok = ok && e == h->exceptions;
+    }
+
+    munmap(map, size);
+    return ok;
+#endif
+}
+
+bool write_plan_cache(const char* filename, const ResamplePlan& plan) {
+#if _WIN32 || _WIN64
+    (void)filename, (void)plan;
+    return false;
+#else
+    int g = std::gcd(plan.N, plan.M);
+    PlanFileHeader h;
+    memcpy(h.magic, PLAN_MAGIC, sizeof(PLAN_MAGIC));
+    h.version = PLAN_VERSION;
+    h.scalar = sizeof(double);
+    h.N = plan.N, h.M = plan.M, h.K = plan.K, h.method = plan.method;
+    h.taps = plan.taps, h.phases = plan.phases();
+    h.period = plan.M / g, h.shift = plan.N / g;  // 輸出每前進 M / g，輸入剛好前進 N / g
+    h.head = std::min(h.period, plan.M);
+
+    // 第一個週期以外，只記錄不符合週期規律的位置 (邊界附近)
+    std::vector<int32_t> head, exc;
+    for (int j = 0; j < plan.M; j++) {
+        if (j < h.head) {
+            head.push_back(plan.start[j]), head.push_back(plan.phase[j]);
+        } else if (plan.start[j] != plan.start[j - h.period] + h.shift || plan.phase[j] != plan.phase[j - h.period]) {
+            exc.push_back(j), exc.push_back(plan.start[j]), exc.push_back(plan.phase[j]);
+        }
+    }
+    h.exceptions = exc.size() / 3;
+
+    size_t wbytes = plan.weights.size() * sizeof(double);
+    std::vector<char> file(sizeof(h) + wbytes + (head.size() + exc.size()) * sizeof(int32_t));
+    char* p = file.data() + sizeof(h);
+    memcpy(p, plan.weights.data(), wbytes), p += wbytes;
+    memcpy(p, head.data(), head.size() * sizeof(int32_t)), p += head.size() * sizeof(int32_t);
+    memcpy(p, exc.data(), exc.size() * sizeof(int32_t));
+    h.checksum = 0;
+    memcpy(file.data(), &h, sizeof(h));
+    h.checksum = plan_checksum(file.data(), file.size());
+    memcpy(file.data(), &h, sizeof(h));
+
+    // 先寫到暫存檔再改名，避免其他程序讀到寫到一半的檔案
+    std::string tmp = std::string(filename) + ".tmp." + std::to_string(getpid());
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(file.data(), 1, file.size(), f) == file.size();
+    ok = (fclose(f) == 0) && ok;
+    if (ok) ok = rename(tmp.c_str(), filename) == 0;
+    if (!ok) remove(tmp.c_str());
+    return ok;
+#endif
+}
+
+ResamplePlan get_plan(int N, int M, int K, int method) {
+    const char* dir = getenv("SUPER_PLAN_CACHE");
+    if (!dir || !*dir) return ResamplePlan(N, M, K, method);  // 未啟用快取
+
+    std::string filename = std::string(dir) + "/" + plan_cache_name(N, M, K, method);
+    ResamplePlan plan;
+    if (read_plan_cache(filename.c_str(), plan, N, M, K, method)) return plan;
+
+    plan = ResamplePlan(N, M, K, method);
+#if !(_WIN32 || _WIN64)
+    mkdir(dir, 0755);  // 資料夾已存在時會失敗，不影響
+#endif
+    if (!write_plan_cache(filename.c_str(), plan))
+        std::cerr << "Warning: Unable to write plan cache `" << filename << "'" << std::endl;
+    return plan;
+}
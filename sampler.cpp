@@ -0,0 +1,161 @@
+#include "sampler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "interpolation.h"
+#include "plan.h"
+#include "plan_cache.h"
+#include "utils.h"
+
+PointSampler::PointSampler(ConstImageView src_, int dstWidth, int dstHeight, int blockSize, int method,
+                           size_t cacheChunks)
+    : src(src_),
+      clamping(method & 0x0F),
+      capacity(std::max<size_t>(1, (cacheChunks + SAMPLER_SHARDS - 1) / SAMPLER_SHARDS)) {
+    if ((method & 0xF0) > USE_METHOD_SLIDING) {  // 未知的方法
+        std::cerr << "Error: Unknown method code " << std::hex << method << std::endl;
+        return;
+    }
+    if (clamping == NORMALIZE_AT_END) {
+        std::cerr << "Error: NORMALIZE_AT_END needs the whole image and cannot be used for point queries" << std::endl;
+        return;
+    }
+    if (src.empty() || dstWidth <= 0 || dstHeight <= 0) return;
+
+    plan_x = get_plan(src.width, dstWidth, blockSize, method);
+    plan_y = get_plan(src.height, dstHeight, blockSize, method);
+    valid = true;
+}
+
+/**
+ * 第 j 個輸出位置的插值：取樣點 ys 與計畫中權重的內積，運算順序與 super_sample 的兩個方向相同，結果也完全相同
+ *
+ * @tparam T 計算使用的純量型別 (double 或 float)
+ * @param ys 取樣點 (plan.taps 個)
+ * @param plan 重取樣計畫
+ * @param j 輸出位置
+ * @param clamped 是否將結果限制在 [0, 1]
+ * @return 插值結果
+ */
+template <typename T>
+static float interpolate(const float* ys, const ResamplePlan& plan, int j, bool clamped) {
+    const T* w = plan.weight<T>(j);
+    T value = 0;
+    for (int t = 0; t < plan.taps; t++)
+        value += w[t] * ys[t];
+    if (clamped) value = clamp(value);
+    return value;
+}
+
+// 計算第 row 個中間列的第 chunk 段 (輸出行 [chunk * SAMPLER_CHUNK, (chunk + 1) * SAMPLER_CHUNK))
+std::vector<float> PointSampler::compute_chunk(int row, int chunk) const {
+    int j0 = chunk * SAMPLER_CHUNK, j1 = std::min(plan_x.M, j0 + SAMPLER_CHUNK);
+    std::vector<float> values(j1 - j0);
+    bool clamped = (clamping == CLAMP_EACH_STEP), single = (plan_x.method & USE_FLOAT32);
+    const float* in = src.row(row);
+    for (int j = j0; j < j1; j++)
+        values[j - j0] = single ? interpolate<float>(in + plan_x.start[j], plan_x, j, clamped)
+                                : interpolate<double>(in + plan_x.start[j], plan_x, j, clamped);
+    return values;
+}
+
+// 中間列段所在的分片：同一段中相鄰的中間列放在同一個分片，一次查詢通常只需要鎖一、兩個分片
+int PointSampler::shard_of(int row, int chunk) const {
+    return (int)(((uint64_t)chunk * 7919 + row / SAMPLER_SHARD_ROWS) % SAMPLER_SHARDS);
+}
+
+// 將計算好的段放進分片 (已存在時忽略)，分片已滿時以 CLOCK 演算法移除一段最近沒有被使用的
+void PointSampler::insert(Shard& shard, int64_t key, std::vector<float>&& values) {
+    std::unique_lock<std::shared_mutex> lk(shard.lock);
+    if (shard.cache.count(key)) return;  // 其他執行緒已經放進快取了
+
+    if (shard.ring.size() < capacity) {
+        shard.ring.push_back(key);
+    } else {
+        for (;; shard.hand = (shard.hand + 1) % shard.ring.size()) {
+            Entry& victim = shard.cache.find(shard.ring[shard.hand])->second;
+            if (!victim.referenced.load(std::memory_order_relaxed)) break;
+            victim.referenced.store(false, std::memory_order_relaxed);  // 給第二次機會
+        }
+        shard.cache.erase(shard.ring[shard.hand]);
+        shard.ring[shard.hand] = key;
+        shard.hand = (shard.hand + 1) % shard.ring.size();
+    }
+    shard.cache[key].values = std::move(values);
+}
+
+/**
+ * 計算輸出影像第 y 列第 x 行的像素
+ * 依序在各分片中以共享鎖找出需要的中間列段，缺少的在不持有鎖的情況下計算後再放進快取
+ *
+ * @param x 輸出的行
+ * @param y 輸出的列
+ * @return 像素值，超出範圍或參數錯誤時回傳 0
+ */
+float PointSampler::sample(int x, int y) {
+    if (!valid || x < 0 || y < 0 || x >= plan_x.M || y >= plan_y.M) return 0.0f;
+
+    const int taps = plan_y.taps, top = plan_y.start[y], chunk = x / SAMPLER_CHUNK, col = x - chunk * SAMPLER_CHUNK;
+    const int64_t chunks = (plan_x.M + SAMPLER_CHUNK - 1) / SAMPLER_CHUNK;
+
+    // 每個中間列在 x 的值，取樣點數不多時放在堆疊上
+    float buffer[SAMPLER_MAX_TAPS];
+    std::vector<float> heap;
+    float* ys = buffer;
+    if (taps > SAMPLER_MAX_TAPS) heap.resize(taps), ys = heap.data();
+
+    for (int t = 0; t < taps;) {
+        const int s = shard_of(top + t, chunk);
+        Shard& shard = shards[s];
+        int found = 0;
+        bool missing = false;
+        {
+            std::shared_lock<std::shared_mutex> lk(shard.lock);
+            for (; t < taps && shard_of(top + t, chunk) == s; t++, found++) {
+                auto it = shard.cache.find((top + t) * chunks + chunk);
+                if (it == shard.cache.end()) {
+                    missing = true;
+                    break;
+                }
+                Entry& entry = it->second;
+                if (!entry.referenced.load(std::memory_order_relaxed))  // 避免每次命中都寫入
+                    entry.referenced.store(true, std::memory_order_relaxed);
+                ys[t] = entry.values[col];
+            }
+        }
+        if (found) shard.hit_count.fetch_add(found, std::memory_order_relaxed);
+
+        if (missing) {
+            std::vector<float> values = compute_chunk(top + t, chunk);
+            ys[t] = values[col];
+            insert(shard, (top + t) * chunks + chunk, std::move(values));
+            shard.miss_count.fetch_add(1, std::memory_order_relaxed);
+            t++;
+        }
+    }
+
+    // 行方向插值
+    bool clamped = (clamping == CLAMP_EACH_STEP);
+    float value = (plan_y.method & USE_FLOAT32) ? interpolate<float>(ys, plan_y, y, clamped)
+                                                : interpolate<double>(ys, plan_y, y, clamped);
+    return clamping == CLAMP_AT_END ? clamp(value) : value;
+}
+
+uint64_t PointSampler::hits() const {
+    uint64_t n = 0;
+    for (const Shard& shard : shards)
+        n += shard.hit_count.load(std::memory_order_relaxed);
+    return n;
+}
+
+uint64_t PointSampler::misses() const {
+    uint64_t n = 0;
+    for (const Shard& shard : shards)
+        n += shard.miss_count.load(std::memory_order_relaxed);
+    return n;
+}
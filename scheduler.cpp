@@ -0,0 +1,101 @@
+#include "scheduler.h"
+
+#include <mutex>
+#include <utility>
+
+#include "parallel.h"
+
+static thread_local int current_worker = -1;            // 目前執行緒在排程器中的編號
+static thread_local const TaskScheduler* current_owner;  // 目前執行緒所屬的排程器
+
+TaskScheduler::TaskScheduler(int threads) {
+    if (threads <= 0) threads = default_threads();
+    for (int i = 0; i < threads; i++)
+        queues.emplace_back(new Queue);
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back([this, i] { run(i); });
+}
+
+TaskScheduler::~TaskScheduler() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lk(sleep_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers)
+        w.join();
+}
+
+/**
+ * 提交工作
+ * 在排程器的執行緒中提交時放進自己的佇列，否則輪流放進各個佇列
+ *
+ * @param task 要執行的工作
+ */
+void TaskScheduler::submit(Task task) {
+    int self = (current_owner == this) ? current_worker : (int)(next++ % queues.size());
+
+    pending++;
+    {
+        std::lock_guard<std::mutex> lk(queues[self]->lock);
+        queues[self]->tasks.push_back(std::move(task));
+    }
+    queued++;
+
+    { std::lock_guard<std::mutex> lk(sleep_lock); }  // 避免與正要睡眠的執行緒錯過通知
+    wake.notify_one();
+}
+
+void TaskScheduler::wait() {
+    std::unique_lock<std::mutex> lk(sleep_lock);
+    idle.wait(lk, [this] { return pending == 0; });
+}
+
+/**
+ * 取出一個工作：先從自己佇列的尾端取，沒有的話從其他佇列的前端偷
+ *
+ * @param self 執行緒編號
+ * @param task 取出的工作
+ * @return 是否取得工作
+ */
+bool TaskScheduler::pop(int self, Task& task) {
+    int n = queues.size();
+    for (int k = 0; k < n; k++) {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lk(q.lock);
+        if (q.tasks.empty()) continue;
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::run(int self) {
+    current_worker = self;
+    current_owner = this;
+
+    Task task;
+    while (true) {
+        if (pop(self, task)) {
+            task();
+            task = nullptr;
+            if (--pending == 0) {
+                { std::lock_guard<std::mutex> lk(sleep_lock); }
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(sleep_lock);
+        wake.wait(lk, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,55 @@
+#include "stats.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "json.h"
+
+bool stats_enabled = false;
+
+static std::atomic<uint64_t> stage_ns[STAGE_COUNT], stage_calls[STAGE_COUNT], counters[COUNTER_COUNT];
+
+static std::mutex excursion_lock;
+static double min_value = 0.0, max_value = 1.0;  // clamp 前的最小值、最大值，與 super_sample_finish 的初始值相同
+
+void stats_add_time(Stage stage, uint64_t ns) {
+    stage_ns[stage].fetch_add(ns, std::memory_order_relaxed);
+    stage_calls[stage].fetch_add(1, std::memory_order_relaxed);
+}
+
+void stats_add(Counter counter, uint64_t n) {
+    if (stats_enabled) counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void stats_add_file(Counter counter, const char* filename) {
+    struct stat st;
+    if (stats_enabled && stat(filename, &st) == 0) stats_add(counter, st.st_size);
+}
+
+void stats_excursion(double mn, double mx) {
+    if (!stats_enabled) return;
+    std::lock_guard<std::mutex> lk(excursion_lock);
+    min_value = std::min(min_value, mn), max_value = std::max(max_value, mx);
+}
+
+std::string stats_json(uint64_t wall_ns) {
+    const char* stages[] = {"readImage", "row_pass", "transposeImage", "col_pass", "clamp_normalize", "writeImage"};
+    const char* names[] = {"pixels_produced", "window_reloads",     "bytes_read",
+                           "bytes_written",   "buffer_allocations", "buffer_reuses"};
+
+    std::string out = "{\n    \"wall_seconds\": " + json_number(wall_ns * 1e-9) + ",\n    \"stages\": {";
+    for (int s = 0; s < STAGE_COUNT; s++)
+        out += std::string(s ? "," : "") + "\n        \"" + stages[s] +
+               "\": {\"calls\": " + std::to_string(stage_calls[s].load()) +
+               ", \"seconds\": " + json_number(stage_ns[s].load() * 1e-9) + "}";
+    out += "\n    },\n    \"counters\": {";
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        out += std::string(c ? "," : "") + "\n        \"" + names[c] + "\": " + std::to_string(counters[c].load());
+    out += ",\n        \"min_before_clamp\": " + json_number(min_value) +
+           ",\n        \"max_before_clamp\": " + json_number(max_value) + "\n    }\n}";
+    return out;
+}
@@ -0,0 +1,319 @@
+#include "stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "image.h"
+#include "image_bin.h"
+#include "interpolation.h"
+#include "parallel.h"
+#include "plan.h"
+#include "plan_cache.h"
+#include "simd.h"
+#include "stats.h"
+#include "text_io.h"
+#include "tiled.h"
+#include "utils.h"
+
+#define READ_BUFFER (1 << 20)  // 讀取緩衝區的大小 (bytes)
+
+// 與 isspace 相同 (C locale)
+static inline bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+ImageRowReader::ImageRowReader(const char* filename) : name(filename) {
+    if (isTiledImage(filename)) {
+        tiled.reset(new TiledImageReader(filename));
+        if (!tiled->ok()) return;
+        width = tiled->width, height = tiled->height, tile = tiled->tile;
+        tile_rows.resize((size_t)tile * width);
+        return;
+    }
+
+    binary = isBinaryImage(filename);
+    file = fopen(filename, "rb");
+    if (!file) {
+        perror("Failed to open file");
+        return;
+    }
+
+    if (binary) {
+        ImageFileHeader h;
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if (size < 0 || fread(&h, sizeof(h), 1, file) != 1 || !validImageHeader(&h, size) ||
+            fseek(file, h.offset, SEEK_SET) != 0) {
+            fprintf(stderr, "Invalid file format: %s\n", filename);
+            fclose(file), file = NULL;
+            return;
+        }
+        width = h.width, height = h.height, stride = h.stride;
+        setvbuf(file, NULL, _IOFBF, READ_BUFFER);
+        return;
+    }
+
+    buf.resize(READ_BUFFER);
+    const char *begin, *end;
+    int size[2];
+    for (int& v : size) {
+        if (!next_token(begin, end) || !parse_text_value(begin, end, v) || v < 0) {
+            fprintf(stderr, "Invalid file format: %s\n", filename);
+            fclose(file), file = NULL;
+            return;
+        }
+    }
+    width = size[0], height = size[1];
+}
+
+ImageRowReader::~ImageRowReader() {
+    if (file) fclose(file);
+}
+
+/**
+ * 取得下一個以空白分隔的字串，緩衝區中的字串可能被切斷時會先補充緩衝區
+ *
+ * @param begin 字串的開頭
+ * @param end 字串的結尾
+ * @return 是否還有字串
+ */
+bool ImageRowReader::next_token(const char*& begin, const char*& end) {
+    while (true) {
+        while (pos < len && is_space(buf[pos]))
+            pos++;
+        size_t e = pos;
+        while (e < len && !is_space(buf[e]))
+            e++;
+        if (e < len || (eof && e > pos)) {  // 完整的字串
+            begin = buf.data() + pos, end = buf.data() + e;
+            pos = e;
+            return true;
+        }
+        if (eof) return false;
+
+        // 將剩下的部分移到開頭再讀取，字串比緩衝區還長時加大緩衝區
+        memmove(buf.data(), buf.data() + pos, len - pos);
+        len -= pos, pos = 0;
+        if (len == buf.size()) buf.resize(2 * buf.size());
+        size_t n = fread(buf.data() + len, 1, buf.size() - len, file);
+        len += n;
+        eof = (n == 0);
+    }
+}
+
+bool ImageRowReader::read_row(float* out) {
+    if (tiled) {
+        if (row >= height) {
+            fprintf(stderr, "Invalid pixel data at row %d, col %d\n", row, 0);
+            return false;
+        }
+        if (row % tile == 0) {  // 解碼下一列區塊
+            int h = std::min(tile, height - row);
+            std::vector<float*> rows(h);
+            for (int i = 0; i < h; i++)
+                rows[i] = tile_rows.data() + (size_t)i * width;
+            Image band = {width, h, rows.data(), tile_rows.data(), NULL, NULL, 0};
+            if (!tiled->read_region(0, row, band)) return false;
+        }
+        memcpy(out, tile_rows.data() + (size_t)(row % tile) * width, width * sizeof(float));
+    } else if (binary) {
+        size_t n = fread(out, sizeof(float), width, file);
+        if (n == (size_t)width && stride > width * sizeof(float))  // 跳過每列結尾的空隙
+            fseek(file, stride - width * sizeof(float), SEEK_CUR);
+        if (n != (size_t)width) {
+            fprintf(stderr, "Invalid pixel data at row %d, col %d\n", row, (int)n);
+            return false;
+        }
+    } else {
+        const char *begin, *end;
+        for (int j = 0; j < width; j++) {
+            if (!next_token(begin, end) || !parse_text_value(begin, end, out[j])) {
+                fprintf(stderr, "Invalid pixel data at row %d, col %d\n", row, j);
+                return false;
+            }
+        }
+    }
+    row++;
+    return true;
+}
+
+ImageRowWriter::ImageRowWriter(const char* filename, int width, int height) {
+    if (hasTiledExtension(filename)) {
+        tiled.reset(new TiledImageWriter(filename, width, height));
+        return;
+    }
+
+    binary = hasBinaryExtension(filename);
+    file = fopen(filename, "wb");
+    if (!file) {
+        perror("Error opening output file");
+        return;
+    }
+
+    if (binary) {
+        ImageFileHeader h = makeImageHeader(width, height);
+        good = fwrite(&h, sizeof(h), 1, file) == 1;
+    } else {
+        good = fprintf(file, "%d %d\n", width, height) > 0;
+    }
+}
+
+ImageRowWriter::~ImageRowWriter() {
+    close();
+}
+
+bool ImageRowWriter::write_rows(const Image& image, int row0, int row1, int threads) {
+    if (!ok()) return false;
+    if (tiled) return tiled->write_rows(image, row0, row1, threads);
+    if (binary) {
+        for (int i = row0; i < row1 && good; i++)
+            good = fwrite(image.data[i], sizeof(float), image.width, file) == (size_t)image.width;
+    } else {
+        good = write_text_rows(file, image, row0, row1, threads);
+    }
+    return good;
+}
+
+bool ImageRowWriter::close() {
+    if (tiled) return tiled->close();
+    if (!file) return false;
+    good = (fclose(file) == 0) && good;
+    file = NULL;
+    if (!good) perror("Error writing output file");
+    return good;
+}
+
+// 重取樣計畫佔用的記憶體 (bytes)
+static size_t plan_bytes(const ResamplePlan& plan) {
+    return plan.start.size() * 2 * sizeof(int) + plan.weights.size() * (sizeof(double) + sizeof(float));
+}
+
+// 分塊格式讀寫一列區塊佔用的記憶體 (bytes)：一列區塊的像素、編碼結果，以及每個執行緒的區塊暫存空間
+static size_t tiled_bytes(int tile, size_t row, int threads) {
+    return 2 * tile * row + (size_t)threads * 2 * tile * tile * sizeof(float);
+}
+
+bool super_sample_stream(const char* srcFilename, const char* dstFilename, int dstWidth, int dstHeight,
+                         int blockSize, int method, size_t memoryLimit, int threads) {
+    if ((method & 0xF0) > USE_METHOD_SLIDING) {  // 未知的方法
+        std::cerr << "Error: Unknown method code " << std::hex << method << std::endl;
+        return false;
+    }
+
+    int srcWidth, srcHeight, srcTile;
+    {
+        ImageRowReader probe(srcFilename);  // 先讀取輸入的大小
+        if (!probe.ok()) return false;
+        srcWidth = probe.width, srcHeight = probe.height, srcTile = probe.tile;
+    }
+
+    ResamplePlan plan_x = get_plan(srcWidth, dstWidth, blockSize, method), plan_y_own;
+    bool shared = (srcWidth == srcHeight && dstWidth == dstHeight);  // 正方形影像兩個方向可以共用
+    if (!shared) plan_y_own = get_plan(srcHeight, dstHeight, blockSize, method);
+    const ResamplePlan& plan_y = shared ? plan_x : plan_y_own;
+    int clamping = method & 0x0F;
+    if (threads <= 0) threads = default_threads();
+
+    // 估計記憶體用量：計畫、列指標、每個執行緒的中間列環形緩衝區與輸入輸出的緩衝區為固定的部分，
+    // 其餘分給輸出區帶，以及區帶需要的輸入列 (每個輸出列約需要 srcHeight / dstHeight 個輸入列)
+    const int margin = 2 * Simd<float>::LANES;  // 串流計算時一次最多多算一個批次的中間列
+    size_t row_out = (size_t)dstWidth * sizeof(float), row_in = (size_t)srcWidth * sizeof(float);
+    size_t fixed = plan_bytes(plan_x) + (shared ? 0 : plan_bytes(plan_y)) +
+                   (size_t)(dstHeight + srcHeight) * sizeof(float*) +
+                   (size_t)threads * (plan_y.taps + margin) * row_out + (size_t)(plan_y.taps + margin + 1) * row_in +
+                   (srcTile ? tiled_bytes(srcTile, row_in, threads) : 0);
+    if (hasTiledExtension(dstFilename))
+        fixed += tiled_bytes(TILE_SIZE, row_out, threads);
+    else if (!hasBinaryExtension(dstFilename))
+        fixed += (size_t)threads * ((1 << 20) + 10 * row_out);
+    size_t per_row = row_out + row_in * srcHeight / dstHeight + row_in;
+    if (memoryLimit < fixed + per_row) {
+        std::cerr << "Error: Memory limit too small, need at least " << ((fixed + per_row) >> 20) + 1 << " MB"
+                  << std::endl;
+        return false;
+    }
+    int band = (int)std::min<size_t>(dstHeight, (memoryLimit - fixed) / per_row);  // 每個區帶的列數
+
+    // 輸入列的滑動視窗要能容納任何一個區帶需要的所有輸入列
+    int window = 1;
+    for (int b0 = 0; b0 < dstHeight; b0 += band) {
+        int b1 = std::min(dstHeight, b0 + band);
+        int hi = std::min(srcHeight, plan_y.start[b1 - 1] + plan_y.taps + margin);
+        window = std::max(window, hi - plan_y.start[b0]);
+    }
+
+    // 第 r 個輸入列放在視窗的第 r % window 列，第 i 個輸出列放在區帶的第 i - b0 列
+    std::vector<float> ring((size_t)window * srcWidth), out((size_t)band * dstWidth);
+    std::vector<float*> src_rows(srcHeight), dst_rows(dstHeight);
+    for (int r = 0; r < srcHeight; r++)
+        src_rows[r] = ring.data() + (size_t)(r % window) * srcWidth;
+    Image src = {srcWidth, srcHeight, src_rows.data(), ring.data(), NULL, NULL, 0};
+    Image dst = {dstWidth, dstHeight, dst_rows.data(), out.data(), NULL, NULL, 0};
+
+    std::vector<std::pair<double, double>> p1(threads, {0.0, 1.0}), p2(threads, {0.0, 1.0});
+    double mn = 0.0, mx = 1.0;  // 整張影像的最小值、最大值 (正規化用)
+
+    // 依序計算每個區帶，writer 為 NULL 時只計算最小值、最大值
+    auto run = [&](ImageRowWriter* writer) {
+        ImageRowReader reader(srcFilename);
+        if (!reader.ok() || reader.width != srcWidth || reader.height != srcHeight) return false;
+
+        int loaded = 0;  // [0, loaded) 的輸入列已經讀過
+        for (int b0 = 0; b0 < dstHeight; b0 += band) {
+            int b1 = std::min(dstHeight, b0 + band);
+            int hi = std::min(srcHeight, plan_y.start[b1 - 1] + plan_y.taps + margin);
+            {
+                ScopedTimer timer(STAGE_READ);
+                for (; loaded < hi; loaded++)
+                    if (!reader.read_row(src_rows[loaded])) return false;
+            }
+
+            for (int i = b0; i < b1; i++)
+                dst_rows[i] = out.data() + (size_t)(i - b0) * dstWidth;
+
+            // 區帶內再切成列區段平行計算
+            int strips = std::max(1, std::min(threads, (b1 - b0) / margin));
+            parallel_for(0, strips, 1, strips, [&](int lo, int hi_) {
+                for (int t = lo; t < hi_; t++) {
+                    int row0 = b0 + (long long)(b1 - b0) * t / strips;
+                    int row1 = b0 + (long long)(b1 - b0) * (t + 1) / strips;
+                    super_sample_rows(src, dst, plan_x, plan_y, clamping, row0, row1, p1[t], p2[t]);
+                }
+            });
+
+            if (!writer) continue;
+            if (clamping == NORMALIZE_AT_END) {
+                ScopedTimer timer(STAGE_CLAMP);
+                for (int i = b0; i < b1; i++)
+                    for (int j = 0; j < dstWidth; j++)
+                        dst.data[i][j] = normalize(dst.data[i][j], mn, mx);
+            }
+            ScopedTimer timer(STAGE_WRITE);
+            if (!writer->write_rows(dst, b0, b1, threads)) return false;
+        }
+        stats_add_file(BYTES_READ, srcFilename);
+        return true;
+    };
+
+    if (clamping == NORMALIZE_AT_END) {  // 正規化需要整張影像的最小值、最大值，先完整計算一次但不輸出
+        if (!run(NULL)) return false;
+        for (auto [lo, hi] : p1)
+            mx = std::max(mx, hi), mn = std::min(mn, lo);
+        for (auto [lo, hi] : p2)
+            mx = std::max(mx, hi), mn = std::min(mn, lo);
+    }
+
+    ImageRowWriter writer(dstFilename, dstWidth, dstHeight);
+    if (!writer.ok()) return false;
+    bool ok = run(&writer);
+    {
+        ScopedTimer timer(STAGE_WRITE);
+        ok = writer.close() && ok;
+    }
+    stats_add_file(BYTES_WRITTEN, dstFilename);
+    return ok;
+}
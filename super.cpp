@@ -1,38 +1,200 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
 
 #include "image.h"
+#include "image_bin.h"
+#include "image_pool.h"
 #include "interpolation.h"
+#include "plan_cache.h"
 #include "read.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "stream.h"
+#include "sweep.h"
 #include "write.h"
 
 using namespace std;
 
-int main(int argc, char** argv) {
-    string srcFilename = "image/image1.txt";  // 輸入檔案名稱
-    int srcSize = 0, dstSize = 0;             // 輸入、輸出影像大小 (N*N, M*M)
+#define STRIP_COST (1 << 24)  // 每個列區段大約的計算量 (乘加次數)
 
-    // 讀取命令列參數
-    if (argc > 1) srcFilename = argv[1];    // 自訂輸入檔案
-    if (argc > 2) dstSize = atoi(argv[2]);  // 自訂輸出大小
+// 一個 (影像, K, 方法) 的計算工作
+struct Job {
+    const Image* src;
+    Image dst;
+    string dstFilename;
+    int k, method;
+    shared_ptr<ResamplePlan> plan_x, plan_y;
 
-    // 讀取輸入影像
-    Image src = readImage(srcFilename.c_str());
+    int strips;                           // 切成幾個列區段
+    vector<pair<double, double>> p1, p2;  // 各區段的最小值、最大值
+    atomic<int> remaining{0};             // 尚未完成的區段數量
+    double cost() const { return (double)dst.width * dst.height * plan_y->taps; }
+};
 
-    if (!src.data) {  // 讀取失敗
-        cerr << "Error: Unable to read image from " << srcFilename << endl;
-        freeImage(src);
+static mutex print_lock;  // 避免多個執行緒的輸出交錯
+
+/**
+ * 執行一個工作：將輸出影像切成數個列區段提交給排程器，最後一個完成的區段負責寫出檔案
+ * 計算量大的工作 (K 較大) 會被切成較多區段，讓閒置的執行緒可以偷走
+ */
+static void run_job(TaskScheduler& scheduler, Job& job) {
+    {
+        lock_guard<mutex> lk(print_lock);
+        cout << "Generating `" << job.dstFilename << "' ..." << endl;
+    }
+
+    int height = job.dst.height;
+    job.strips = max(1, min(height / 8, (int)(job.cost() / STRIP_COST)));
+    job.p1.assign(job.strips, {0.0, 1.0});
+    job.p2.assign(job.strips, {0.0, 1.0});
+    job.remaining = job.strips;
+
+    for (int s = 0; s < job.strips; s++) {
+        scheduler.submit([&job, s, height] {
+            int row0 = (long long)height * s / job.strips, row1 = (long long)height * (s + 1) / job.strips;
+            super_sample_rows(*job.src, job.dst, *job.plan_x, *job.plan_y, job.method & 0x0F, row0, row1, job.p1[s],
+                              job.p2[s]);
+
+            if (--job.remaining == 0) {  // 最後一個完成的區段
+                super_sample_finish(job.dst, job.method & 0x0F, job.p1, job.p2, 1);
+                if (!job.dst.mapping) {  // 對應到檔案的影像已經寫好了
+                    ScopedTimer timer(STAGE_WRITE);
+                    writeImage(job.dstFilename.c_str(), job.dst);
+                }
+                releaseImage(job.dst);  // 相同大小的下一個工作可以重複使用
+                stats_add_file(BYTES_WRITTEN, job.dstFilename.c_str());
+            }
+        });
+    }
+}
+
+/**
+ * 參數掃描模式：./super --sweep <input> <reference> <K_max> <threads> <output_dir>
+ * 對三種區塊選擇方法、兩種 clamp 時機與 K = 1 ~ K_max 的所有組合進行 super sampling 並與參考影像比較，
+ * 結果寫成 <output_dir>/<method>_<clamp>.json (預設為 image/)，過程中不會寫出任何影像
+ */
+static int run_sweep(int argc, char** argv) {
+    const char* srcFilename = argc > 2 ? argv[2] : "image/image1.txt";
+    const char* refFilename = argc > 3 ? argv[3] : "image/image2.txt";
+    int kMax = argc > 4 ? atoi(argv[4]) : 64;
+    int threads = argc > 5 ? atoi(argv[5]) : 0;
+    string dir = argc > 6 ? argv[6] : "image";  // 預設不覆寫 plots/ 中的參考數據
+
+    Image src, ref;
+    {
+        ScopedTimer timer(STAGE_READ);
+        src = readImage(srcFilename), ref = readImage(refFilename);
+    }
+    stats_add_file(BYTES_READ, srcFilename), stats_add_file(BYTES_READ, refFilename);
+    if (!src.data || !ref.data) {
+        cerr << "Error: Unable to read image from " << (src.data ? refFilename : srcFilename) << endl;
+        freeImage(src), freeImage(ref);
         return 1;
     }
 
-    if (src.width != src.height) {  // 目前只支援正方形影像
-        cerr << "Error: Input image must be square." << endl;
-        freeImage(src);
+    vector<int> methods, ks;
+    for (int m : {USE_METHOD_BLOCK, USE_METHOD_OVERLAP, USE_METHOD_SLIDING})
+        for (int c : {CLAMP_EACH_STEP, CLAMP_AT_END})
+            methods.push_back(m | c);
+    for (int k = 1; k <= kMax; k++)
+        ks.push_back(k);
+
+    cout << "Sweeping " << methods.size() * ks.size() << " combinations ..." << endl;
+    vector<SweepResult> results = sweep(src, ref, methods, ks, threads);
+    freeImage(src), freeImage(ref);
+    return write_sweep_json(results, dir) ? 0 : 1;
+}
+
+static uint64_t start_time;  // 程式開始的時間 (--stats)
+
+// 以 JSON 輸出各階段的計時與計數器 (--stats)
+static void print_stats() {
+    if (stats_enabled) cout << stats_json(stats_now() - start_time) << endl;
+}
+
+int main(int argc, char** argv) {
+    // --stats 可以放在任何位置，移除後其餘參數的位置不變
+    int args = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0)
+            stats_enabled = true;
+        else
+            argv[args++] = argv[i];
+    }
+    argc = args;
+    start_time = stats_now();
+
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) {
+        int ret = run_sweep(argc, argv);
+        print_stats();
+        return ret;
+    }
+
+    string srcFilenames = "image/image1.txt";  // 輸入檔案名稱，多個檔案以逗號分隔
+    int dstSize = 0;                           // 輸出影像大小 (M*M)
+    int threads = 0;                           // 執行緒數量 (0: 使用所有核心)
+    size_t memoryLimit = 0;                    // 記憶體用量上限 (0: 不限制，整張影像放在記憶體中)
+
+    // 讀取命令列參數
+    if (argc > 1) srcFilenames = argv[1];                      // 自訂輸入檔案
+    if (argc > 2) dstSize = atoi(argv[2]);                     // 自訂輸出大小
+    if (argc > 3) threads = atoi(argv[3]);                     // 自訂執行緒數量
+    if (argc > 4) memoryLimit = (size_t)atoll(argv[4]) << 20;  // 自訂記憶體上限 (MB)，啟用串流模式
+
+    const char* format = getenv("SUPER_OUTPUT_FORMAT");  // 指定輸出格式 (txt、bin 或 tiles)
+    if (format && strcmp(format, "txt") && strcmp(format, "bin") && strcmp(format, "tiles")) {
+        cerr << "Error: Unknown output format " << format << endl;
         return 1;
     }
 
-    srcSize = src.width;                  // 輸入影像大小
-    if (!dstSize) dstSize = srcSize * 8;  // 預設放大 8 倍
+    // 讀取輸入影像
+    vector<string> names;
+    for (size_t pos = 0; pos <= srcFilenames.size();) {
+        size_t comma = min(srcFilenames.find(',', pos), srcFilenames.size());
+        names.push_back(srcFilenames.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+
+    vector<Image> srcs;
+    vector<int> srcSizes;  // 輸入影像大小
+    for (const string& name : names) {
+        Image src = {0, 0, NULL, NULL, NULL, NULL, 0};
+        bool ok;
+        if (memoryLimit) {  // 串流模式只讀取大小，計算時才逐列讀取
+            ImageRowReader probe(name.c_str());
+            ok = probe.ok(), src.width = probe.width, src.height = probe.height;
+        } else {
+            ScopedTimer timer(STAGE_READ);
+            src = readImage(name.c_str());
+            ok = src.data != NULL;
+            stats_add_file(BYTES_READ, name.c_str());
+        }
+
+        if (!ok) {  // 讀取失敗
+            cerr << "Error: Unable to read image from " << name << endl;
+            freeImage(src);
+        } else if (src.width != src.height) {  // 目前只支援正方形影像
+            cerr << "Error: Input image must be square." << endl;
+            freeImage(src);
+        } else {
+            srcs.push_back(src);
+            srcSizes.push_back(src.width);
+            continue;
+        }
+
+        for (Image& img : srcs)
+            freeImage(img);
+        return 1;
+    }
 
     // 刪除舊的輸出檔案
 #if _WIN32 || _WIN64  // Windows
@@ -42,31 +204,110 @@ int main(int argc, char** argv) {
 #endif
     assert(ret == 0);  // 命令應該要成功執行
 
-    // 進行 super sampling
+    // 建立所有 (影像, K) 的工作，相同尺寸的影像共用重取樣計畫
     vector<int> k_list = {1, 2, 4, 8, 16, 32};  // 不同的 K 值測試
-    string outputs;                             // 輸出檔案名稱列表
+    int method = USE_METHOD_SLIDING | CLAMP_AT_END;
+    string outputs;  // 輸出檔案名稱列表 (display、convert 不支援分塊格式，因此不包含 *.tiles)
 
-    for (int k : k_list) {
-        string dstFilename = "image/output_" + to_string(k) + ".txt";
-        outputs += " " + dstFilename;
-        cout << "Generating `" << dstFilename << "' ..." << endl;
+    map<tuple<int, int, int>, shared_ptr<ResamplePlan>> plans;  // (N, M, K) -> 計畫
+    vector<unique_ptr<Job>> jobs;
+    vector<tuple<string, string, int, int>> streams;  // 串流模式的 (輸入, 輸出, M, K)
 
-        Image dst = zerosImage(dstSize, dstSize, dstFilename.c_str());  // 輸出影像
-        super_sample(src, dst, k, USE_METHOD_SLIDING | CLAMP_AT_END);
-        writeImage(dstFilename.c_str(), dst);
-        freeImage(dst);
+    // 多張影像時以輸入檔名 (不含路徑與副檔名) 區分輸出，不同資料夾中的同名檔案加上輸入順序 (從 1 開始) 區分
+    vector<string> stems(names.size());
+    if (names.size() > 1) {
+        map<string, int> count;
+        for (size_t i = 0; i < names.size(); i++) {
+            string stem = names[i].substr(names[i].find_last_of("/\\") + 1);
+            stems[i] = stem.substr(0, stem.find_last_of('.'));
+            count[stems[i]]++;
+        }
+        set<string> used;
+        for (size_t i = 0; i < names.size(); i++)
+            if (count[stems[i]] == 1) used.insert(stems[i]);
+        for (size_t i = 0; i < names.size(); i++) {
+            if (count[stems[i]] == 1) continue;
+            string stem = stems[i] + "_" + to_string(i + 1);
+            while (used.count(stem))  // 與其他輸入的檔名相同時繼續加上後綴
+                stem += "_" + to_string(i + 1);
+            used.insert(stems[i] = stem);
+        }
+    }
+
+    for (size_t i = 0; i < srcs.size(); i++) {
+        int srcSize = srcSizes[i];
+        int size = dstSize ? dstSize : srcSize * 8;  // 預設放大 8 倍
+        string prefix = "image/output_";
+        const char* name = names[i].c_str();
+        string ext = isTiledImage(name) ? ".tiles" : isBinaryImage(name) ? ".bin" : ".txt";  // 輸出格式與輸入相同
+        if (format) ext = string(".") + format;
+        if (srcs.size() > 1) prefix += stems[i] + "_";
+
+        for (int k : k_list) {
+            if (memoryLimit) {
+                streams.emplace_back(names[i], prefix + to_string(k) + ext, size, k);
+                if (ext != ".tiles") outputs += " " + get<1>(streams.back());
+                continue;
+            }
+
+            auto& plan = plans[{srcSize, size, k}];
+            if (!plan) plan = make_shared<ResamplePlan>(get_plan(srcSize, size, k, method));
+
+            unique_ptr<Job> job(new Job);
+            job->src = &srcs[i];
+            job->dstFilename = prefix + to_string(k) + ext;
+            job->dst = {size, size, NULL, NULL, NULL, NULL, 0};  // 執行時才配置記憶體
+            job->k = k, job->method = method;
+            job->plan_x = job->plan_y = plan;
+            if (ext != ".tiles") outputs += " " + job->dstFilename;
+            jobs.push_back(move(job));
+        }
+    }
+
+    // 進行 super sampling：計算量大的工作先開始，避免最後只剩一個大工作在執行
+    vector<Job*> order;
+    for (auto& job : jobs)
+        order.push_back(job.get());
+    stable_sort(order.begin(), order.end(), [](const Job* a, const Job* b) { return a->cost() > b->cost(); });
+
+    if (memoryLimit) {
+        // 串流模式：一次只執行一個工作 (工作內部仍使用所有執行緒)，記憶體用量不超過上限
+        for (auto& [src, dst, size, k] : streams) {
+            cout << "Generating `" << dst << "' ..." << endl;
+            if (!super_sample_stream(src.c_str(), dst.c_str(), size, size, k, method, memoryLimit, threads)) return 1;
+        }
+    } else {
+        TaskScheduler scheduler(threads);
+        for (Job* job : order) {
+            scheduler.submit([&scheduler, job] {
+                // 輸出影像，二進位格式直接對應到輸出檔案
+                const char* name = job->dstFilename.c_str();
+                int w = job->dst.width, h = job->dst.height;
+                // 每個像素都會被覆寫，從緩衝區池取得時不需要清零
+                job->dst = hasBinaryExtension(name) ? createImageFile(name, w, h) : acquireImage(w, h, false);
+                if (!job->dst.data) job->dst = acquireImage(w, h, false);  // 無法建立檔案時，最後由 writeImage 回報錯誤
+                run_job(scheduler, *job);
+            });
+        }
+        scheduler.wait();
     }
 
     // 釋放記憶體
-    freeImage(src);
+    for (Image& src : srcs)
+        freeImage(src);
+    print_stats();
 
     // 顯示輸入、輸出影像
+    if (outputs.empty()) return 0;
+    string inputs;
+    for (const string& name : names)
+        if (!isTiledImage(name.c_str())) inputs += " " + name;
 #if _WIN32  // Windows
-    string command = "./display.exe " + srcFilename + outputs;
+    string command = "./display.exe" + inputs + outputs;
 #elif __APPLE__ && __MACH__  // macOS
     string command = "./convert" + outputs;
 #elif __linux__              // Linux
-    string command = "./display " + srcFilename + outputs + " & ./convert" + outputs;
+    string command = "./display" + inputs + outputs + " & ./convert" + outputs;
 #endif
     ret = system(command.c_str());
     assert(ret == 0);  // 命令應該要成功執行
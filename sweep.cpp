@@ -0,0 +1,116 @@
+#include "sweep.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "image_pool.h"
+#include "interpolation.h"
+#include "json.h"
+#include "metrics.h"
+#include "plan.h"
+#include "plan_cache.h"
+#include "scheduler.h"
+
+std::vector<SweepResult> sweep(const Image& src, const Image& ref, const std::vector<int>& methods,
+                               const std::vector<int>& ks, int threads) {
+    std::vector<SweepResult> results(methods.size() * ks.size());
+
+    // 重取樣計畫與 clamp 時機無關，相同 (區塊選擇方法, K) 的組合共用計畫與輸出影像，依序計算各個 clamp 時機
+    std::map<int, std::vector<size_t>> groups;  // 不含 clamp 時機的方法 -> methods 中的位置
+    for (size_t m = 0; m < methods.size(); m++)
+        groups[methods[m] & ~0x0F].push_back(m);
+
+    // K 較大的組合計算量較大，先開始執行
+    std::vector<size_t> order(ks.size());
+    for (size_t i = 0; i < ks.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ks[a] > ks[b]; });
+
+    TaskScheduler scheduler(threads);
+    for (size_t i : order) {
+        for (auto& group : groups) {
+            int base = group.first, k = ks[i];
+            const std::vector<size_t>* members = &group.second;
+            scheduler.submit([&, base, k, i, members] {
+                ResamplePlan plan_x = get_plan(src.width, ref.width, k, base), plan_y_own;
+                bool shared = (src.width == src.height && ref.width == ref.height);  // 正方形影像兩個方向可以共用
+                if (!shared) plan_y_own = get_plan(src.height, ref.height, k, base);
+                const ResamplePlan& plan_y = shared ? plan_x : plan_y_own;
+
+                // 每個組合只使用一個執行緒，平行度來自同時執行的多個組合
+                Image dst = acquireImage(ref.width, ref.height, false);  // 每個像素都會被覆寫
+                for (size_t m : *members) {
+                    SweepResult& r = results[m * ks.size() + i];
+                    r.method = methods[m], r.k = k;
+                    super_sample(src, dst, plan_x, plan_y, methods[m] & 0x0F, 1);
+                    compare_images(dst, ref, r.metrics, 1);
+                }
+                releaseImage(dst);
+            });
+        }
+    }
+    scheduler.wait();
+    return results;
+}
+
+const char* method_name(int method) {
+    switch (method & 0xF0) {
+        case USE_METHOD_BLOCK:
+            return "block";
+        case USE_METHOD_OVERLAP:
+            return "overlap";
+        case USE_METHOD_SLIDING:
+            return "sliding";
+        default:
+            return "unknown";
+    }
+}
+
+// 寫出一個方法的結果，格式與 compare.py 以 json.dump(indent=4) 寫出的相同
+static bool write_method_json(const std::string& filename, const std::vector<const SweepResult*>& results) {
+    FILE* file = fopen(filename.c_str(), "w");
+    if (!file) {
+        perror("Error opening output file");
+        return false;
+    }
+
+    const char* names[] = {"MSE", "PSNR", "SSIM"};
+    std::string out = "{";
+    for (int f = 0; f < 3; f++) {
+        out += std::string(f ? "," : "") + "\n    \"" + names[f] + "\": {";
+        for (size_t i = 0; i < results.size(); i++) {
+            const ImageMetrics& m = results[i]->metrics;
+            double value = f == 0 ? m.mse : f == 1 ? m.psnr : m.ssim;
+            out += std::string(i ? "," : "") + "\n        \"" + std::to_string(results[i]->k) +
+                   "\": " + json_number(value, f == 1 ? 2 : 6);
+        }
+        out += "\n    }";
+    }
+    out += "\n}";
+
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) perror("Error writing output file");
+    return ok;
+}
+
+bool write_sweep_json(const std::vector<SweepResult>& results, const std::string& dir) {
+    std::map<int, std::vector<const SweepResult*>> by_method;
+    for (const SweepResult& r : results)
+        by_method[r.method].push_back(&r);
+
+    bool ok = true;
+    for (auto& [method, list] : by_method) {
+        std::string name = method_name(method);
+        if (method & USE_BARYCENTRIC) name += "_barycentric";
+        if (method & USE_FLOAT32) name += "_float32";
+        std::string filename = dir + "/" + name + "_" + std::to_string(method & 0x0F) + ".json";
+        printf("Writing `%s' ...\n", filename.c_str());
+        ok = write_method_json(filename, list) && ok;
+    }
+    return ok;
+}
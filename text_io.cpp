@@ -0,0 +1,220 @@
+#include "text_io.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "file_contents.h"
+#include "image.h"
+#include "parallel.h"
+
+#define PARSE_CHUNK (1 << 20)  // 每個解析區段的最小大小 (bytes)，太小的檔案不值得開執行緒
+
+// 與 isspace 相同 (C locale)
+static inline bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * 解析一個數值，與 scanf 一樣允許開頭的 '+'，數值之後必須是空白或檔案結尾
+ *
+ * @param p 數值的開頭，成功時移到數值之後
+ * @param end 檔案結尾
+ * @param value 解析結果
+ * @return 是否成功
+ */
+template <typename T>
+static bool parse_number(const char*& p, const char* end, T& value) {
+    const char* q = p + (p < end && *p == '+');
+    auto r = std::from_chars(q, end, value);
+    if (r.ec == std::errc::result_out_of_range) {  // scanf 會得到 inf 或 0，交給 strtof 處理
+        value = (T)strtod(std::string(q, r.ptr).c_str(), NULL);
+        r.ec = std::errc();
+    }
+    if (r.ec != std::errc() || (r.ptr < end && !is_space(*r.ptr))) return false;
+    p = r.ptr;
+    return true;
+}
+
+bool parse_text_value(const char*& p, const char* end, float& value) {
+    return parse_number(p, end, value);
+}
+
+bool parse_text_value(const char*& p, const char* end, int& value) {
+    return parse_number(p, end, value);
+}
+
+// 計算 [begin, end) 中以空白分隔的數值個數，begin 之前視為空白
+static long long count_tokens(const char* begin, const char* end) {
+    long long n = 0;
+    bool space = true;
+    for (const char* p = begin; p < end; p++) {
+        bool s = is_space(*p);
+        n += space && !s;
+        space = s;
+    }
+    return n;
+}
+
+/**
+ * 解析 [begin, end) 中的數值，依序寫入 out[first], out[first + 1], ...，只寫到 out[total - 1] 為止
+ *
+ * @return 第一個無法解析的數值的位置，全部成功時回傳 total
+ */
+static long long parse_tokens(const char* begin, const char* end, float* out, long long first, long long total) {
+    const char* p = begin;
+    for (long long i = first; i < total; i++) {
+        while (p < end && is_space(*p))
+            p++;
+        if (p == end) break;
+        if (!parse_number(p, end, out[i])) return i;
+    }
+    return total;
+}
+
+Image readTextImage(const char* filename, int threads) {
+    Image image;
+    memset(&image, 0, sizeof(image));
+
+    FileContents file(filename);
+    if (!file.ok) {
+        perror("Failed to open file");
+        return image;
+    }
+    const char *p = file.data, *end = file.data + file.size;
+
+    // 讀取寬與高
+    int size[2];
+    for (int& v : size) {
+        while (p < end && is_space(*p))
+            p++;
+        if (!parse_number(p, end, v) || v < 0) {
+            fprintf(stderr, "Invalid file format: %s\n", filename);
+            return image;
+        }
+    }
+
+    image = zerosImage(size[0], size[1], filename);
+    long long total = (long long)image.width * image.height;
+
+    // 切成以換行對齊的區段，每個區段開頭都在一列的開頭
+    if (threads <= 0) threads = default_threads();
+    int chunks = std::max(1, (int)std::min<long long>(threads, (end - p) / PARSE_CHUNK));
+    std::vector<const char*> bounds = {p};
+    for (int c = 1; c < chunks; c++) {
+        const char* q = std::max(bounds.back(), p + (end - p) * c / chunks);
+        const char* nl = (const char*)memchr(q, '\n', end - q);
+        bounds.push_back(nl ? nl + 1 : end);
+    }
+    bounds.push_back(end);
+
+    // 先計算每個區段的數值個數，得到各區段第一個像素的位置，再平行解析
+    std::vector<long long> first(chunks + 1, 0), bad(chunks, total);
+    parallel_for(0, chunks, 1, threads, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++)
+            first[c + 1] = count_tokens(bounds[c], bounds[c + 1]);
+    });
+    for (int c = 0; c < chunks; c++)
+        first[c + 1] += first[c];
+
+    parallel_for(0, chunks, 1, threads, [&](int lo, int hi) {
+        for (int c = lo; c < hi; c++)
+            if (first[c] < total) bad[c] = parse_tokens(bounds[c], bounds[c + 1], image.buffer, first[c], total);
+    });
+
+    // 第一個錯誤的位置：無法解析的數值，或是數值不足
+    long long error = std::min(total, first[chunks]);
+    for (long long b : bad)
+        error = std::min(error, b);
+    if (error < total) {
+        fprintf(stderr, "Invalid pixel data at row %d, col %d\n", (int)(error / image.width),
+                (int)(error % image.width));
+        freeImage(image);
+        memset(&image, 0, sizeof(image));
+    }
+    return image;
+}
+
+#define FORMAT_BLOCK (1 << 20)  // 每個執行緒一次格式化的大約大小 (bytes)
+#define MAX_VALUE_CHARS 400     // 一個 "%.6f" 數值加上分隔字元的最大長度 (double 最大約 309 位整數)
+
+/**
+ * 以 "%.6f" 的格式輸出一個 float
+ * float 乘上 10^6 在 double 中是精確的 (24 + 20 bits < 53 bits)，因此以 nearbyint 取整數 (四捨六入五成雙)
+ * 得到的結果與 printf 完全相同；nan、inf 與很大的數值交給 std::to_chars
+ *
+ * @return 輸出結尾的位置
+ */
+static inline char* format_fixed6(char* p, char* end, float x) {
+    double d = x;
+    if (!(std::fabs(d) < 1e12)) return std::to_chars(p, end, d, std::chars_format::fixed, 6).ptr;
+
+    if (std::signbit(d)) *p++ = '-', d = -d;  // printf 會保留 -0 的負號
+    unsigned long long n = (unsigned long long)std::nearbyint(d * 1e6);
+    p = std::to_chars(p, end, n / 1000000).ptr;
+    *p = '.';
+    for (int k = 6, frac = n % 1000000; k > 0; k--, frac /= 10)
+        p[k] = '0' + frac % 10;
+    return p + 7;
+}
+
+/**
+ * 以 "%.6f" 的格式將第 [row0, row1) 列寫到 out 的開頭，數值之間以空白分隔，每列以換行結尾
+ * out 不夠大時會自動加大，之後的呼叫可以重複使用
+ *
+ * @return 寫入的大小 (bytes)
+ */
+static size_t format_rows(const Image& image, int row0, int row1, std::vector<char>& out) {
+    size_t used = 0;
+    for (int i = row0; i < row1; i++) {
+        const float* row = image.data[i];
+        for (int j = 0; j < image.width; j++) {
+            if (out.size() - used < MAX_VALUE_CHARS) out.resize(std::max(2 * out.size(), used + MAX_VALUE_CHARS));
+            char* p = format_fixed6(out.data() + used, out.data() + out.size(), row[j]);
+            *p++ = (j < image.width - 1) ? ' ' : '\n';
+            used = p - out.data();
+        }
+    }
+    return used;
+}
+
+bool write_text_rows(FILE* file, const Image& image, int row0, int row1, int threads) {
+    // 每一輪由每個執行緒各格式化一個列區塊，再依序寫出，記憶體用量與影像大小無關
+    if (threads <= 0) threads = default_threads();
+    int rows = std::max(1, FORMAT_BLOCK / std::max(1, 9 * image.width));  // 每個區塊的列數 ("0.xxxxxx " 為 9 bytes)
+    threads = std::max(1, std::min(threads, (row1 - row0 + rows - 1) / rows));
+    std::vector<std::vector<char>> buffers(threads);
+    std::vector<size_t> used(threads);
+
+    bool ok = true;
+    for (int i = row0; i < row1 && ok; i += rows * threads) {
+        parallel_for(0, threads, 1, threads, [&](int lo, int hi) {
+            for (int t = lo; t < hi; t++) {
+                int r0 = std::min(row1, i + t * rows), r1 = std::min(row1, r0 + rows);
+                used[t] = format_rows(image, r0, r1, buffers[t]);
+            }
+        });
+        for (int t = 0; t < threads && ok; t++)
+            ok = fwrite(buffers[t].data(), 1, used[t], file) == used[t];
+    }
+    return ok;
+}
+
+bool writeTextImage(const char* filename, const Image& image, int threads) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        perror("Error opening output file");
+        return false;
+    }
+    bool ok = fprintf(file, "%d %d\n", image.width, image.height) > 0;
+    ok = ok && write_text_rows(file, image, 0, image.height, threads);
+
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) perror("Error writing output file");
+    return ok;
+}
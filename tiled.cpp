@@ -0,0 +1,361 @@
+#include "tiled.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "file_contents.h"
+#include "image.h"
+#include "image_bin.h"
+#include "parallel.h"
+
+/**
+ * 區塊的壓縮方式 (無失真)
+ *
+ * 1. 將 float 的位元視為 uint32，每個像素減去前一個像素 (相鄰像素通常很接近，高位元組大多為 0 或 0xFF)
+ * 2. 將差值的 4 個位元組分成 4 個平面，讓相同位置的位元組排在一起
+ * 3. 以 PackBits 風格的 RLE 編碼：控制位元組 c < 128 表示接下來 c + 1 個位元組直接複製，
+ *    否則表示下一個位元組重複 c - 125 次 (3 ~ 130 次)
+ *
+ * 壓縮後沒有變小的區塊直接存放原始像素。
+ */
+
+#define RLE_MAX_LITERAL 128
+#define RLE_MIN_RUN 3
+#define RLE_MAX_RUN 130
+
+// RLE 編碼 n 個位元組最多需要的大小
+static size_t rle_bound(size_t n) {
+    return n + n / RLE_MAX_LITERAL + 1;
+}
+
+// RLE 編碼，out 至少要有 rle_bound(n) bytes，回傳編碼後的大小
+static size_t rle_encode(const uint8_t* in, size_t n, uint8_t* out) {
+    size_t o = 0, lit = 0;  // [lit, i) 是還沒輸出的直接複製部分
+    auto flush = [&](size_t end) {
+        for (; lit < end; lit += RLE_MAX_LITERAL) {
+            size_t len = std::min<size_t>(RLE_MAX_LITERAL, end - lit);
+            out[o++] = (uint8_t)(len - 1);
+            memcpy(out + o, in + lit, len);
+            o += len;
+        }
+        lit = end;
+    };
+
+    for (size_t i = 0; i < n;) {
+        size_t run = 1;
+        while (i + run < n && run < RLE_MAX_RUN && in[i + run] == in[i])
+            run++;
+        if (run >= RLE_MIN_RUN) {
+            flush(i);
+            out[o++] = (uint8_t)(run + 125);
+            out[o++] = in[i];
+            lit = i + run;
+        }
+        i += run;
+    }
+    flush(n);
+    return o;
+}
+
+// RLE 解碼，輸出必須剛好是 n bytes
+static bool rle_decode(const uint8_t* in, size_t size, uint8_t* out, size_t n) {
+    const uint8_t* end = in + size;
+    size_t o = 0;
+    while (in < end) {
+        uint8_t c = *in++;
+        if (c < RLE_MAX_LITERAL) {
+            size_t len = c + 1;
+            if (len > (size_t)(end - in) || len > n - o) return false;
+            memcpy(out + o, in, len);
+            in += len, o += len;
+        } else {
+            size_t len = c - 125;
+            if (in == end || len > n - o) return false;
+            memset(out + o, *in++, len);
+            o += len;
+        }
+    }
+    return o == n;
+}
+
+/**
+ * 編碼一個區塊
+ *
+ * @param pixels 區塊的像素 (n 個，依列優先順序排列)
+ * @param n 像素個數
+ * @param compress 是否嘗試壓縮
+ * @param planes 暫存空間 (會自動加大)
+ * @param out 編碼結果
+ * @return TILE_RAW 或 TILE_COMPRESSED
+ */
+static uint32_t encode_tile(const float* pixels, size_t n, bool compress, std::vector<uint8_t>& planes,
+                            std::vector<uint8_t>& out) {
+    size_t raw = n * sizeof(float);
+    if (compress) {
+        planes.resize(raw);
+        out.resize(rle_bound(raw));
+        uint32_t prev = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t bits, d;
+            memcpy(&bits, pixels + i, sizeof(bits));
+            d = bits - prev, prev = bits;
+            for (int k = 0; k < 4; k++)
+                planes[k * n + i] = (uint8_t)(d >> (8 * k));
+        }
+        size_t size = rle_encode(planes.data(), raw, out.data());
+        if (size < raw) {
+            out.resize(size);
+            return TILE_COMPRESSED;
+        }
+    }
+    out.resize(raw);
+    memcpy(out.data(), pixels, raw);
+    return TILE_RAW;
+}
+
+bool isTiledImage(const char* filename) {
+    char magic[sizeof(TILED_MAGIC)];
+    FILE* file = fopen(filename, "rb");
+    if (!file) return false;
+    bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, TILED_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return ok;
+}
+
+bool hasTiledExtension(const char* filename) {
+    size_t len = strlen(filename);
+    return len >= 6 && strcmp(filename + len - 6, ".tiles") == 0;
+}
+
+TiledImageReader::TiledImageReader(const char* filename) : file(new FileContents(filename, false)) {
+    if (!file->ok) {
+        perror("Failed to open file");
+        return;
+    }
+
+    TiledFileHeader h;
+    if (file->size < sizeof(h)) {
+        fprintf(stderr, "Invalid file format: %s\n", filename);
+        return;
+    }
+    memcpy(&h, file->data, sizeof(h));
+    if (memcmp(h.magic, TILED_MAGIC, sizeof(h.magic)) != 0 || h.version != TILED_VERSION ||
+        h.dtype != IMAGE_DTYPE_F32 || h.width <= 0 || h.height <= 0 || h.tile <= 0) {
+        fprintf(stderr, "Invalid file format: %s\n", filename);
+        return;
+    }
+
+    int tx = (h.width + h.tile - 1) / h.tile, ty = (h.height + h.tile - 1) / h.tile;
+    uint64_t count = (uint64_t)tx * ty;
+    if (h.index < sizeof(h) || h.index % alignof(TileEntry) != 0 || h.index > file->size ||
+        (file->size - h.index) / sizeof(TileEntry) < count) {
+        fprintf(stderr, "Invalid file format: %s\n", filename);
+        return;
+    }
+
+    width = h.width, height = h.height, tile = h.tile;
+    tiles_x = tx, tiles_y = ty;
+    index = (const TileEntry*)(file->data + h.index);  // mmap 的位置對齊頁面，index 是 16 的倍數
+}
+
+TiledImageReader::~TiledImageReader() = default;
+
+/**
+ * 解碼第 (tx, ty) 個區塊
+ *
+ * @param out 輸出，大小為區塊的寬 x 高
+ * @return 區塊資料是否合法
+ */
+bool TiledImageReader::decode(int tx, int ty, float* out) const {
+    const TileEntry& e = index[(size_t)ty * tiles_x + tx];
+    size_t w = std::min(tile, width - tx * tile), h = std::min(tile, height - ty * tile);
+    size_t n = w * h, raw = n * sizeof(float);
+    if (e.offset < sizeof(TiledFileHeader) || e.offset > file->size || e.size > file->size - e.offset) return false;
+    const uint8_t* data = (const uint8_t*)file->data + e.offset;
+
+    if (e.codec == TILE_RAW) {
+        if (e.size != raw) return false;
+        memcpy(out, data, raw);
+        return true;
+    }
+    if (e.codec != TILE_COMPRESSED) return false;
+
+    std::vector<uint8_t> planes(raw);
+    if (!rle_decode(data, e.size, planes.data(), raw)) return false;
+    uint32_t prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t d = planes[i] | planes[n + i] << 8 | planes[2 * n + i] << 16 | (uint32_t)planes[3 * n + i] << 24;
+        prev += d;
+        memcpy(out + i, &prev, sizeof(prev));
+    }
+    return true;
+}
+
+bool TiledImageReader::read_region(int x0, int y0, Image& dst, int threads) const {
+    if (!ok() || x0 < 0 || y0 < 0 || dst.width <= 0 || dst.height <= 0 || dst.width > width - x0 ||
+        dst.height > height - y0) {
+        fprintf(stderr, "Invalid region (%d, %d) %d x %d\n", x0, y0, dst.width, dst.height);
+        return false;
+    }
+
+    // 只解碼與區域重疊的區塊，每個區塊寫入的範圍互不重疊，可以平行處理
+    int tx0 = x0 / tile, tx1 = (x0 + dst.width - 1) / tile + 1;
+    int ty0 = y0 / tile, ty1 = (y0 + dst.height - 1) / tile + 1;
+    int cols = tx1 - tx0, count = cols * (ty1 - ty0);
+    std::vector<char> bad(count, 0);
+    parallel_for(0, count, 1, threads, [&](int lo, int hi) {
+        std::vector<float> buf((size_t)tile * tile);
+        for (int c = lo; c < hi; c++) {
+            int tx = tx0 + c % cols, ty = ty0 + c / cols;
+            if (!decode(tx, ty, buf.data())) {
+                bad[c] = 1;
+                continue;
+            }
+            int w = std::min(tile, width - tx * tile);
+            int c0 = std::max(x0, tx * tile), c1 = std::min(x0 + dst.width, tx * tile + w);
+            int r0 = std::max(y0, ty * tile), r1 = std::min(y0 + dst.height, (ty + 1) * tile);
+            for (int r = r0; r < r1; r++)
+                memcpy(dst.data[r - y0] + (c0 - x0), buf.data() + (size_t)(r - ty * tile) * w + (c0 - tx * tile),
+                       (c1 - c0) * sizeof(float));
+        }
+    });
+
+    for (int c = 0; c < count; c++) {
+        if (bad[c]) {
+            fprintf(stderr, "Invalid tile data at tile (%d, %d)\n", tx0 + c % cols, ty0 + c / cols);
+            return false;
+        }
+    }
+    return true;
+}
+
+TiledImageWriter::TiledImageWriter(const char* filename, int width_, int height_, int tile_, bool compress_)
+    : width(width_), height(height_), tile(tile_), tiles_x((width_ + tile_ - 1) / tile_), compress(compress_) {
+    file = fopen(filename, "wb");
+    if (!file) {
+        perror("Error opening output file");
+        return;
+    }
+
+    // 先寫入標頭佔位，close() 時再補上索引的位置
+    TiledFileHeader h;
+    memset(&h, 0, sizeof(h));
+    good = fwrite(&h, sizeof(h), 1, file) == 1;
+    offset = sizeof(h);
+    pending.resize((size_t)tile * width);
+}
+
+TiledImageWriter::~TiledImageWriter() {
+    close();
+}
+
+bool TiledImageWriter::write_rows(const Image& image, int row0, int row1, int threads) {
+    if (!ok()) return false;
+    for (int i = row0; i < row1 && good; i++) {
+        memcpy(pending.data() + (size_t)(rows % tile) * width, image.data[i], width * sizeof(float));
+        rows++;
+        if (rows % tile == 0 || rows == height) good = flush(threads);
+    }
+    return good;
+}
+
+/**
+ * 平行編碼一列區塊，再依序寫入檔案
+ *
+ * @return 是否成功
+ */
+bool TiledImageWriter::flush(int threads) {
+    int ty = (rows - 1) / tile, h = rows - ty * tile;
+    std::vector<std::vector<uint8_t>> out(tiles_x);
+    std::vector<uint32_t> codec(tiles_x);
+    parallel_for(0, tiles_x, 1, threads, [&](int lo, int hi) {
+        std::vector<float> pixels((size_t)tile * tile);
+        std::vector<uint8_t> planes;
+        for (int tx = lo; tx < hi; tx++) {
+            int w = std::min(tile, width - tx * tile);
+            for (int r = 0; r < h; r++)
+                memcpy(pixels.data() + (size_t)r * w, pending.data() + (size_t)r * width + tx * tile,
+                       w * sizeof(float));
+            codec[tx] = encode_tile(pixels.data(), (size_t)w * h, compress, planes, out[tx]);
+        }
+    });
+
+    for (int tx = 0; tx < tiles_x; tx++) {
+        if (fwrite(out[tx].data(), 1, out[tx].size(), file) != out[tx].size()) return false;
+        tiles.push_back({offset, (uint32_t)out[tx].size(), codec[tx]});
+        offset += out[tx].size();
+    }
+    return true;
+}
+
+bool TiledImageWriter::close() {
+    if (!file) return false;
+    if (good && rows != height) {
+        fprintf(stderr, "Error: Only %d of %d rows were written\n", rows, height);
+        good = false;
+    }
+
+    // 索引對齊 16 bytes，讀取時可以直接當成 TileEntry 陣列
+    if (good) {
+        static const char zeros[sizeof(TileEntry)] = {};
+        size_t pad = (sizeof(TileEntry) - offset % sizeof(TileEntry)) % sizeof(TileEntry);
+        good = fwrite(zeros, 1, pad, file) == pad;
+        offset += pad;
+    }
+    if (good) good = fwrite(tiles.data(), sizeof(TileEntry), tiles.size(), file) == tiles.size();
+
+    if (good) {
+        TiledFileHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, TILED_MAGIC, sizeof(h.magic));
+        h.version = TILED_VERSION;
+        h.dtype = IMAGE_DTYPE_F32;
+        h.width = width, h.height = height, h.tile = tile;
+        h.compression = compress;
+        h.index = offset;
+        good = fseek(file, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, file) == 1;
+    }
+
+    good = (fclose(file) == 0) && good;
+    file = NULL;
+    if (!good) perror("Error writing output file");
+    return good;
+}
+
+Image readTiledImage(const char* filename, int threads) {
+    Image image;
+    memset(&image, 0, sizeof(image));
+    TiledImageReader reader(filename);
+    if (!reader.ok()) return image;
+    image = zerosImage(reader.width, reader.height, filename);
+    if (!reader.read_region(0, 0, image, threads)) {
+        freeImage(image);
+        memset(&image, 0, sizeof(image));
+    }
+    return image;
+}
+
+Image readTiledRegion(const char* filename, int x0, int y0, int width, int height, int threads) {
+    Image image;
+    memset(&image, 0, sizeof(image));
+    TiledImageReader reader(filename);
+    if (!reader.ok()) return image;
+    if (width <= 0 || height <= 0 || x0 < 0 || y0 < 0 || width > reader.width - x0 || height > reader.height - y0) {
+        fprintf(stderr, "Invalid region (%d, %d) %d x %d\n", x0, y0, width, height);
+        return image;
+    }
+    image = zerosImage(width, height, filename);
+    if (!reader.read_region(x0, y0, image, threads)) {
+        freeImage(image);
+        memset(&image, 0, sizeof(image));
+    }
+    return image;
+}
+
+bool writeTiledImage(const char* filename, const Image& image, int tile, bool compress, int threads) {
+    TiledImageWriter writer(filename, image.width, image.height, tile, compress);
+    if (!writer.ok()) return false;
+    bool ok = writer.write_rows(image, 0, image.height, threads);
+    return writer.close() && ok;
+}
@@ -0,0 +1,24 @@
+#include "transpose.h"
+
+#include "image.h"
+#include "parallel.h"
+#include "stats.h"
+
+/**
+ * 平行轉置影像
+ * 將輸入的列切成數段 (以 TRANSPOSE_TILE 為單位)，每個執行緒負責一段
+ *
+ * @param src 輸入影像
+ * @param dst 輸出影像，由呼叫端配置，大小需為 src.height x src.width
+ * @param threads 執行緒數量，0 表示使用所有核心
+ *
+ * @return 大小不符時回傳 false
+ */
+bool transpose_image(const Image& src, Image& dst, int threads) {
+    if (!src.data || !dst.data || dst.width != src.height || dst.height != src.width) return false;
+    ScopedTimer timer(STAGE_TRANSPOSE);
+
+    parallel_for(0, src.height, TRANSPOSE_TILE, threads,
+                 [&](int lo, int hi) { transposeImageRows(&src, &dst, lo, hi); });
+    return true;
+}